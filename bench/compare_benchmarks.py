@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""Compare benchmark results against a stored baseline.
+
+Both arguments are directories of JSON files written by run_benchmark.py
+(or single JSON files). Results are matched by (name, threads). A result
+is flagged as a regression when its throughput (events/s or photons/s)
+drops, or its peak RSS or initialisation time grows, by more than the
+tolerance. The exit status is 1 if any regression is found.
+
+Usage:
+  compare_benchmarks.py baseline_dir results_dir [--tolerance 0.10]
+"""
+
+import argparse
+import glob
+import json
+import os
+import sys
+
+# (key, True if higher is better)
+METRICS = [
+    ("events_per_s", True),
+    ("photons_per_s", True),
+    ("peak_rss_mb", False),
+    ("init_s", False),
+]
+
+
+def load(path):
+    files = [path] if os.path.isfile(path) else \
+        sorted(glob.glob(os.path.join(path, "*.json")))
+    results = {}
+    for name in files:
+        with open(name) as stream:
+            result = json.load(stream)
+        results[(result["name"], result["threads"])] = result
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--tolerance", type=float, default=0.10,
+                        help="allowed relative change (default 0.10)")
+    args = parser.parse_args()
+
+    if not os.path.exists(args.baseline):
+        print("No baseline at %s, nothing to compare" % args.baseline)
+        return 0
+    baseline = load(args.baseline)
+    current = load(args.current)
+
+    regressions = 0
+    print("%-12s %3s  %-14s %12s %12s %8s" %
+          ("benchmark", "thr", "metric", "baseline", "current", "change"))
+    for key in sorted(current):
+        if key not in baseline:
+            print("%-12s %3d  (no baseline)" % key)
+            continue
+        for metric, higher_is_better in METRICS:
+            old = baseline[key].get(metric, 0.)
+            new = current[key].get(metric, 0.)
+            if old <= 0.:
+                continue
+            change = (new - old) / old
+            worse = -change if higher_is_better else change
+            flag = ""
+            if worse > args.tolerance:
+                flag = "  REGRESSION"
+                regressions += 1
+            print("%-12s %3d  %-14s %12.4g %12.4g %+7.1f%%%s" %
+                  (key[0], key[1], metric, old, new, 100. * change, flag))
+
+    if regressions:
+        print("%d regression(s) beyond %.0f%%" %
+              (regressions, 100. * args.tolerance))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
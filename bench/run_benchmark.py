@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+"""Run one exampleB4c benchmark and write its figures of merit as JSON.
+
+The macro is run in a scratch directory so that concurrent output files
+do not collide. The figures are parsed from the job output:
+  - the "--> Run N timing:" line printed by the master RunAction,
+  - the "Created (all)" and "scintillation in QD" lines of the photon
+    budget table,
+and the peak resident set size is taken from the child rusage.
+
+Usage:
+  run_benchmark.py --exe exampleB4c --macro bench_muon.mac --threads 4 \
+                   --name muon --output results/muon_t4.json
+"""
+
+import argparse
+import json
+import os
+import re
+import resource
+import subprocess
+import sys
+import tempfile
+import time
+
+TIMING = re.compile(r"--> Run \d+ timing: (\d+) events, initialisation "
+                    r"([0-9.eE+-]+) s, event loop ([0-9.eE+-]+) s")
+CREATED = re.compile(r"^\s*Created \(all\)\s+(\d+)", re.MULTILINE)
+SCINT_QD = re.compile(r"^\s*scintillation in QD\s+(\d+)", re.MULTILINE)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--exe", required=True)
+    parser.add_argument("--macro", required=True)
+    parser.add_argument("--threads", type=int, default=1)
+    parser.add_argument("--name", required=True)
+    parser.add_argument("--output", required=True)
+    parser.add_argument("--log", help="keep the job output in this file")
+    args = parser.parse_args()
+
+    command = [os.path.abspath(args.exe), "-m", os.path.abspath(args.macro)]
+    if args.threads > 0:
+        command += ["-t", str(args.threads)]
+
+    with tempfile.TemporaryDirectory(prefix="b4bench_") as scratch:
+        start = time.monotonic()
+        job = subprocess.run(command, cwd=scratch, stdout=subprocess.PIPE,
+                             stderr=subprocess.STDOUT, text=True)
+        wall = time.monotonic() - start
+    log = job.stdout
+    if args.log:
+        with open(args.log, "w") as stream:
+            stream.write(log)
+    if job.returncode != 0:
+        sys.stderr.write(log[-4000:])
+        sys.exit("exampleB4c failed with status %d" % job.returncode)
+
+    timings = TIMING.findall(log)
+    if not timings:
+        sys.exit("no run timing line found in the job output")
+    events = sum(int(t[0]) for t in timings)
+    init = float(timings[0][1])
+    loop = sum(float(t[2]) for t in timings)
+    photons = sum(int(n) for n in CREATED.findall(log))
+    photons_qd = sum(int(n) for n in SCINT_QD.findall(log))
+    # ru_maxrss is in kilobytes on Linux; only one child is run per call
+    rss_mb = resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss / 1024.
+
+    result = {
+        "name": args.name,
+        "macro": os.path.basename(args.macro),
+        "threads": args.threads,
+        "events": events,
+        "init_s": init,
+        "event_loop_s": loop,
+        "wall_s": wall,
+        "events_per_s": events / loop if loop > 0 else 0.,
+        "photons_tracked": photons,
+        "photons_per_s": photons / loop if loop > 0 else 0.,
+        "qd_photons_per_event": photons_qd / events if events > 0 else 0.,
+        "peak_rss_mb": rss_mb,
+    }
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output, "w") as stream:
+        json.dump(result, stream, indent=2, sort_keys=True)
+        stream.write("\n")
+    print(json.dumps(result, sort_keys=True))
+
+
+if __name__ == "__main__":
+    main()
@@ -29,11 +29,15 @@
 
 #include "DetectorConstruction.hh"
 #include "ActionInitialization.hh"
+#include "Checkpoint.hh"
+#include "RunFarm.hh"
+#include "RunMonitor.hh"
 
 #include "G4EmStandardPhysics_option4.hh"
 #include "G4OpticalParameters.hh"
 #include "G4OpticalPhysics.hh"
 #include "G4RunManagerFactory.hh"
+#include "G4StepLimiterPhysics.hh"
 #include "G4SteppingVerbose.hh"
 #include "G4UIcommand.hh"
 #include "G4UImanager.hh"
@@ -48,9 +52,13 @@ namespace {
   void PrintUsage() {
     G4cerr << " Usage: " << G4endl;
     G4cerr << " exampleB4c [-m macro ] [-u UIsession] [-t nThreads] [-vDefault]"
-           << G4endl;
+           << " [-r checkpoint] [-j nProcesses]" << G4endl;
     G4cerr << "   note: -t option is available only for multi-threaded mode."
            << G4endl;
+    G4cerr << "   note: -r resumes the /B4/checkpoint/beamOn run of the macro."
+           << G4endl;
+    G4cerr << "   note: -j runs the macro in nProcesses processes and merges"
+           << " their output (requires -m)." << G4endl;
   }
 }
 
@@ -60,13 +68,16 @@ int main(int argc,char** argv)
 {
   // Evaluate arguments
   //
-  if ( argc > 7 ) {
+  if ( argc > 13 ) {
     PrintUsage();
     return 1;
   }
 
   G4String macro;
   G4String session;
+  G4String checkpointFile;
+  G4String farmShard;
+  G4int nProcesses = 0;
   G4bool verboseBestUnits = true;
 #ifdef G4MULTITHREADED
   G4int nThreads = 0;
@@ -74,6 +85,11 @@ int main(int argc,char** argv)
   for ( G4int i=1; i<argc; i=i+2 ) {
     if      ( G4String(argv[i]) == "-m" ) macro = argv[i+1];
     else if ( G4String(argv[i]) == "-u" ) session = argv[i+1];
+    else if ( G4String(argv[i]) == "-r" ) checkpointFile = argv[i+1];
+    else if ( G4String(argv[i]) == "-p" ) farmShard = argv[i+1];
+    else if ( G4String(argv[i]) == "-j" ) {
+      nProcesses = G4UIcommand::ConvertToInt(argv[i+1]);
+    }
 #ifdef G4MULTITHREADED
     else if ( G4String(argv[i]) == "-t" ) {
       nThreads = G4UIcommand::ConvertToInt(argv[i+1]);
@@ -89,6 +105,16 @@ int main(int argc,char** argv)
     }
   }
 
+  // Run farm launcher: forks the shard processes and merges their output
+  //
+  if ( nProcesses > 0 && ! farmShard.size() ) {
+    if ( ! macro.size() ) {
+      PrintUsage();
+      return 1;
+    }
+    return B4c::RunFarm::Launch(argc, argv, nProcesses);
+  }
+
   // Detect interactive mode (if no macro provided) and define UI session
   //
   G4UIExecutive* ui = nullptr;
@@ -143,6 +169,8 @@ int main(int argc,char** argv)
   opticalParams->SetCerenkovTrackSecondariesFirst(true);
 
   physicsList->RegisterPhysics(opticalPhysics);
+  // User limits of the detector regions
+  physicsList->RegisterPhysics(new G4StepLimiterPhysics());
   runManager->SetUserInitialization(physicsList);
 
   auto actionInitialization = new B4c::ActionInitialization();
@@ -154,6 +182,20 @@ int main(int argc,char** argv)
   // G4VisManager* visManager = new G4VisExecutive("Quiet");
   visManager->Initialize();
 
+  // Checkpointed runs (/B4/checkpoint/), optionally resumed
+  auto checkpoint = new B4c::Checkpoint();
+  checkpoint->SetResumeFile(checkpointFile);
+
+  // Live run monitoring (/B4/monitor/)
+  auto runMonitor = new B4c::RunMonitor();
+
+  // Shard of a run farm (/B4/farm/), started by the launcher with -p
+  B4c::RunFarm* runFarm = nullptr;
+  if ( farmShard.size() ) {
+    runFarm = new B4c::RunFarm(farmShard);
+    macro = runFarm->PrepareMacro(macro);
+  }
+
   // Get the pointer to the User Interface manager
   auto UImanager = G4UImanager::GetUIpointer();
 
@@ -184,6 +226,9 @@ int main(int argc,char** argv)
   // owned and deleted by the run manager, so they should not be deleted
   // in the main() program !
 
+  delete runFarm;
+  delete runMonitor;
+  delete checkpoint;
   delete visManager;
   delete runManager;
 }
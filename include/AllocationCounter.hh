@@ -0,0 +1,59 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file AllocationCounter.hh
+/// \brief Definition of the B4c::AllocationCounter functions
+
+#ifndef B4cAllocationCounter_h
+#define B4cAllocationCounter_h 1
+
+#include "globals.hh"
+
+#include <cstdint>
+
+namespace B4c
+{
+
+/// Heap allocation counting, for checking the steady-state behaviour of
+/// the event loop.
+///
+/// When the project is configured with -DB4_COUNT_ALLOCATIONS=ON, the
+/// global operator new is replaced by one which counts the calls made by
+/// each thread; otherwise IsEnabled() is false and the count stays 0.
+
+namespace AllocationCounter
+{
+  G4bool IsEnabled();
+
+  /// Number of operator new calls made by the calling thread
+  std::uint64_t GetCount();
+}
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
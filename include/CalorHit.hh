@@ -30,6 +30,7 @@
 #ifndef B4cCalorHit_h
 #define B4cCalorHit_h 1
 
+#include "HitPool.hh"
 #include "G4VHit.hh"
 #include "G4THitsCollection.hh"
 #include "G4Allocator.hh"
@@ -81,6 +82,7 @@ class CalorHit : public G4VHit
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 using CalorHitsCollection = G4THitsCollection<CalorHit>;
+using CalorHits = HitPool<CalorHit>;
 
 extern G4ThreadLocal G4Allocator<CalorHit>* CalorHitAllocator;
 
@@ -33,6 +33,7 @@
 #include "G4VSensitiveDetector.hh"
 
 #include "CalorHit.hh"
+#include "PhotonHit.hh"
 
 #include "G4RunManager.hh"
 #include "G4AnalysisManager.hh"
@@ -46,13 +47,27 @@ class G4HCofThisEvent;
 namespace B4c
 {
 
+class Photocathode;
+
 /// Calorimeter sensitive detector class
 ///
-/// In Initialize(), it creates one hit for each calorimeter layer and one more
+/// In Initialize(), it resets one hit for each calorimeter layer and one more
 /// hit for accounting the total quantities in all layers.
 ///
 /// The values are accounted in hits in ProcessHits() function which is called
 /// by Geant4 kernel at each step.
+///
+/// Each accepted optical photon is also stored as a PhotonHit, the input of
+/// the PMT digitisation.
+///
+/// The hits are not handed to the G4HCofThisEvent, which would delete them
+/// at the end of every event: they live in HitPool containers owned by the
+/// (thread-local) detector and reused from event to event, and are read
+/// with GetCalorHits() and GetPhotonHits() via
+/// G4SDManager::FindSensitiveDetector().
+///
+/// When a Photocathode is attached, photons failing its quantum or
+/// collection efficiency are killed before anything is recorded.
 
 class CalorimeterSD : public G4VSensitiveDetector
 {
@@ -67,9 +82,20 @@ class CalorimeterSD : public G4VSensitiveDetector
     G4bool ProcessHits(G4Step* step, G4TouchableHistory* history) override;
     void   EndOfEvent(G4HCofThisEvent* hitCollection) override;
 
+    void SetPhotocathode(const Photocathode* photocathode);
+
+    const CalorHits& GetCalorHits() const { return fCalorHits; }
+    const PhotonHits& GetPhotonHits() const { return fPhotonHits; }
+
+    /// Number of reallocations of the hit pools since the start of the job
+    G4long GetNofPoolGrowths() const
+      { return fCalorHits.GetNofGrowths() + fPhotonHits.GetNofGrowths(); }
+
   private:
-    CalorHitsCollection* fHitsCollection = nullptr;
+    CalorHits fCalorHits;
+    PhotonHits fPhotonHits;
     G4int fNofCells = 0;
+    const Photocathode* fPhotocathode = nullptr;
 };
 
 }
@@ -0,0 +1,106 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file Checkpoint.hh
+/// \brief Definition of the B4c::Checkpoint class
+
+#ifndef B4cCheckpoint_h
+#define B4cCheckpoint_h 1
+
+#include "PhotonCounters.hh"
+#include "globals.hh"
+
+#include <array>
+
+class G4GenericMessenger;
+
+namespace B4c
+{
+
+/// Checkpointed batch runs
+///
+/// /B4/checkpoint/beamOn N replaces /run/beamOn N for long runs: the N
+/// events are processed as consecutive runs (segments) of at most
+/// /B4/checkpoint/segment events. Each segment writes its own output,
+/// <output>_s<NNNN>.root (and its worker shards in sharded mode), which
+/// can be combined with b4merge. After each segment the checkpoint file
+/// is rewritten with the number of completed segments, the event offset,
+/// the accumulated photon budget and the state of the master random
+/// engine. The budget is saved by counter name: a checkpoint written by a
+/// build with other counters, or in another format version, is rejected.
+///
+/// The master engine is the only state to save: in multi-threaded mode
+/// the worker engines are reseeded for each event from seeds drawn on
+/// the master at the start of the run, and in sequential mode it is the
+/// engine used by the events themselves. A resumed job therefore runs
+/// the remaining segments exactly as the uninterrupted job would have.
+///
+/// Resume with "exampleB4c -m macro -r file": the macro is executed as
+/// before and /B4/checkpoint/beamOn continues after the last completed
+/// segment found in the file.
+///
+/// The object lives on the master only (it is created in main()); its
+/// commands are not broadcast to the workers. GetEventOffset() gives the
+/// number of events of the previous segments (or of the previous shards
+/// of a RunFarm run), to be added to the event IDs written in the output.
+
+class Checkpoint
+{
+  public:
+    Checkpoint();
+    ~Checkpoint();
+
+    void SetResumeFile(const G4String& fileName) { fResumeFile = fileName; }
+
+    static G4int GetEventOffset() { return fgEventOffset; }
+    static void SetEventOffset(G4int offset) { fgEventOffset = offset; }
+
+  private:
+    void BeamOn(G4int nofEvents);
+    G4bool Load(const G4String& fileName, G4int nofEvents);
+    void Save() const;
+    void DefineCommands();
+
+    static G4int fgEventOffset;
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4String fFileName = "B4.chk";
+    G4String fOutputName = "B4";
+    G4int fSegmentSize = 1000;
+    G4String fResumeFile;
+
+    // State of the current checkpointed run
+    G4int fRequested = 0;
+    G4int fCompletedSegments = 0;
+    G4int fCompletedEvents = 0;
+    std::array<G4long, PhotonCounters::kNofCounters> fCounters = {};
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
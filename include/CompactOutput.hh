@@ -0,0 +1,85 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file CompactOutput.hh
+/// \brief Definition of the B4c::CompactOutput class
+
+#ifndef B4cCompactOutput_h
+#define B4cCompactOutput_h 1
+
+#include "PhotonCodec.hh"
+#include "PhotonHit.hh"
+#include "globals.hh"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace B4c
+{
+
+/// Writer of the detected photons in the compact encoding (PhotonCodec)
+///
+/// With /B4/output/photons compact or both, the RunAction opens one .b4p
+/// file per thread for the run: <fileName>.b4p in sequential mode,
+/// <fileName>_t<N>.b4p for each worker otherwise. The EventAction adds
+/// the PhotonHits of the sensitive detectors and writes the event, also
+/// when it has no photon. The records are buffered and written by blocks.
+///
+/// One instance per thread, accessed via Instance().
+
+class CompactOutput
+{
+  public:
+    static CompactOutput* Instance();
+    ~CompactOutput();
+
+    G4bool Open(const G4String& fileName);
+    void Close();
+    G4bool IsOpen() const { return fFile.is_open(); }
+
+    void AddHits(const PhotonHits& hits);
+    /// Writes the photons added since the last event, with their times
+    /// relative to the event time t0
+    void WriteEvent(G4int eventID, G4double t0);
+
+  private:
+    CompactOutput() = default;
+
+    void Flush();
+
+    static G4ThreadLocal CompactOutput* fgInstance;
+
+    std::ofstream fFile;
+    std::string fBuffer;
+    std::vector<CompactPhoton> fPhotons;
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -59,11 +59,15 @@
 #include "G4SDManager.hh"
 
 class G4VPhysicalVolume;
+class G4GenericMessenger;
 class G4GlobalMagFieldMessenger;
 
 namespace B4c
 {
 
+class DetectorRegion;
+class Photocathode;
+
 /// Detector construction class to define materials and geometry.
 /// The calorimeter is a box made of a given number of layers. A layer consists
 /// of an absorber plate and of a detection gap. The layer is replicated.
@@ -76,9 +80,36 @@ namespace B4c
 /// - the transverse size of the calorimeter (the input face is a square).
 ///
 /// In ConstructSDandField() sensitive detectors of CalorimeterSD type
-/// are created and associated with the Absorber and Gap volumes.
+/// are created and associated with the Absorber and Gap volumes, and a
+/// KillZoneSD with the world volume outside the black box.
 /// In addition a transverse uniform magnetic field is defined
 /// via G4GlobalMagFieldMessenger class.
+///
+/// The PMT sensitive detector is given the Photocathode model owned by
+/// this class, which applies the quantum and collection efficiencies.
+///
+/// The inner walls of the black box (border surfaces between physBox and
+/// the world, both ways) and the aluminium stand (skin surface) are
+/// ground metal surfaces whose reflectivity is set with
+/// /B4/surface/wallReflectivity and /B4/surface/standReflectivity
+/// (default 0: a photon is absorbed at the first wall it hits). The
+/// reflectivities can be changed between runs.
+///
+/// /B4/geometry/exportGDML writes the constructed geometry, with the
+/// material properties and the optical surfaces, to a GDML file (builds
+/// with the Geant4 GDML module only). With /B4/geometry/cache <file>
+/// (before /run/initialize), Construct() reads the geometry from the file
+/// instead of building it, skipping the overlap checks, if the file is up
+/// to date: a <file>.hash sidecar stores a hash of the configuration (the
+/// source of this class, hashed by CMake, and the Geant4 version) and of
+/// the GDML content. Otherwise the geometry is built and the cache is
+/// rewritten. Settings not stored in GDML (Birks constant, surface
+/// reflectivities) are applied again after reading; the visualisation
+/// attributes are not restored.
+///
+/// The QD, the bottle and the inside of the black box (air, stand and
+/// PMT) are the G4Regions "QD", "Bottle" and "Surroundings", each with
+/// its own production cuts and user limits (see DetectorRegion).
 
 class DetectorConstruction : public G4VUserDetectorConstruction
 {
@@ -95,6 +126,18 @@ class DetectorConstruction : public G4VUserDetectorConstruction
     //
     void DefineMaterials();
     G4VPhysicalVolume* DefineVolumes();
+    void DefineCommands();
+    void DefineRegions();
+
+    G4VPhysicalVolume* ReadGDMLCache();
+    void WriteGDML(const G4String& fileName);
+    void FindSurfaces(const G4VPhysicalVolume* world);
+    static G4String GetConfigHash();
+
+    void SetWallReflectivity(G4double reflectivity);
+    void SetStandReflectivity(G4double reflectivity);
+    static void SetReflectivity(G4OpticalSurface* surface,
+                                G4double reflectivity);
 
     // data members
     //
@@ -102,6 +145,18 @@ class DetectorConstruction : public G4VUserDetectorConstruction
                                       // magnetic field messenger
 
     G4bool fCheckOverlaps = true; // option to activate checking of volumes overlaps
+    Photocathode* fPhotocathode = nullptr; // PMT QE and CE model
+    G4GenericMessenger* fMessenger = nullptr;
+    G4GenericMessenger* fGeometryMessenger = nullptr;
+    G4VPhysicalVolume* fWorld = nullptr;
+    G4String fGDMLCache;         // cached geometry file, none if empty
+    DetectorRegion* fQDRegion = nullptr;
+    DetectorRegion* fBottleRegion = nullptr;
+    DetectorRegion* fSurroundingsRegion = nullptr;
+    G4OpticalSurface* fWallSurface = nullptr;  // black box inner walls
+    G4OpticalSurface* fStandSurface = nullptr; // aluminium stand
+    G4double fWallReflectivity = 0.;
+    G4double fStandReflectivity = 0.;
     G4int  fNofLayers = -1;     // number of layers
     
     G4Material *worldMat, *water, *Aluminum, *Glass, *CdS, *Scint, *fLXe;
@@ -0,0 +1,96 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file DetectorRegion.hh
+/// \brief Definition of the B4c::DetectorRegion class
+
+#ifndef B4cDetectorRegion_h
+#define B4cDetectorRegion_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+class G4GenericMessenger;
+class G4LogicalVolume;
+class G4ProductionCuts;
+class G4Region;
+class G4UserLimits;
+
+namespace B4c
+{
+
+/// A G4Region of the detector with its own production cuts and user
+/// limits, set with the /B4/region/<name>/ commands:
+/// - cut, gammaCut, electronCut, positronCut (default 0.7 mm, as the
+///   physics list default cut),
+/// - maxStep, maxTrackLength, maxTime, minKinEnergy (default: none, also
+///   set by a value of 0).
+///
+/// The cuts and limits can be changed before /run/initialize and between
+/// runs. The user limits are applied by G4StepLimiterPhysics (charged
+/// particles only) and are set on every logical volume of the region,
+/// i.e. the root volumes and their daughters which are not the root of
+/// another region.
+///
+/// The region is created by Attach(), called from
+/// DetectorConstruction::Construct() once the volumes exist (built or
+/// read from the GDML cache).
+
+class DetectorRegion
+{
+  public:
+    explicit DetectorRegion(const G4String& name);
+    ~DetectorRegion();
+
+    void Attach(const std::vector<G4String>& rootVolumes);
+
+    G4Region* GetRegion() const { return fRegion; }
+
+  private:
+    void SetCut(G4double cut);
+    void SetGammaCut(G4double cut);
+    void SetElectronCut(G4double cut);
+    void SetPositronCut(G4double cut);
+    void SetMaxStep(G4double step);
+    void SetMaxTrackLength(G4double length);
+    void SetMaxTime(G4double time);
+    void SetMinKinEnergy(G4double energy);
+
+    void SetLimits(G4LogicalVolume* volume);
+
+    G4String fName;
+    G4Region* fRegion = nullptr;
+    G4ProductionCuts* fCuts = nullptr;
+    G4UserLimits* fLimits = nullptr;
+    G4GenericMessenger* fMessenger = nullptr;
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
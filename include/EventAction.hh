@@ -36,15 +36,25 @@
 
 #include "globals.hh"
 
+#include <cstdint>
+
 
 namespace B4c
 {
-  extern int event_counter;
+  extern G4ThreadLocal int event_counter;
+
+class CalorimeterSD;
+
 /// Event action class
 ///
 /// In EndOfEventAction(), it prints the accumulated quantities of the energy
 /// deposit and track lengths of charged particles in Absober and Gap layers
-/// stored in the hits collections.
+/// stored in the hits of the sensitive detectors, and writes the per-event
+/// photon budget when requested.
+///
+/// When built with B4_COUNT_ALLOCATIONS, it also reports for each printed
+/// event the number of heap allocations made by the thread during the
+/// event and the number of hit pool reallocations (see AllocationCounter).
 class EventAction : public G4UserEventAction
 {
 public:
@@ -56,14 +66,15 @@ public:
 
 private:
   // methods
-  CalorHitsCollection* GetHitsCollection(G4int hcID,
-                                            const G4Event* event) const;
+  const CalorimeterSD* GetSD(const G4String& name) const;
   void PrintEventStatistics(G4double absoEdep, G4double absoTrackLength,
                             G4double gapEdep, G4double gapTrackLength) const;
 
   // data members
-  G4int fAbsHCID = -1;
-  G4int fGapHCID = -1;
+  const CalorimeterSD* fAbsoSD = nullptr;
+  const CalorimeterSD* fGapSD = nullptr;
+  std::uint64_t fAllocationsAtBegin = 0;
+  G4long fPoolGrowthsAtBegin = 0;
 };
 
 }
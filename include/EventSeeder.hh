@@ -0,0 +1,85 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file EventSeeder.hh
+/// \brief Definition of the B4c::EventSeeder class
+
+#ifndef B4cEventSeeder_h
+#define B4cEventSeeder_h 1
+
+#include "globals.hh"
+
+#include <cstdint>
+
+class G4GenericMessenger;
+
+namespace B4c
+{
+
+/// Thread-count independent random seeding
+///
+/// With /B4/random/perEventSeeding true, the random engine of the thread
+/// processing an event is reseeded, at the start of GeneratePrimaries(),
+/// from a hash of (/B4/random/runSeed, event ID). The event ID includes
+/// the offset of a checkpointed run, see Checkpoint. The random sequence
+/// of an event then no longer depends on the number of threads, the
+/// tasking backend, /run/eventModulo or the order in which the workers
+/// pick up the events.
+///
+/// The seeds do not depend on the run ID, so that a resumed checkpointed
+/// run reproduces the uninterrupted one: consecutive /run/beamOn commands
+/// repeat the same events unless the run seed is changed in between.
+///
+/// One instance per thread, accessed via Instance(), so that the commands
+/// exist on the master as well as on the workers.
+
+class EventSeeder
+{
+  public:
+    static EventSeeder* Instance();
+    ~EventSeeder();
+
+    G4bool IsEnabled() const { return fEnabled; }
+
+    void Seed(G4int eventID) const;
+
+    static std::uint64_t Hash(std::uint64_t value);
+
+  private:
+    EventSeeder();
+
+    static G4ThreadLocal EventSeeder* fgInstance;
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4bool fEnabled = false;
+    G4int fRunSeed = 12345;
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,127 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file EventTimer.hh
+/// \brief Definition of the B4c::EventTimer class
+
+#ifndef B4cEventTimer_h
+#define B4cEventTimer_h 1
+
+#include "globals.hh"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+class G4GenericMessenger;
+
+namespace B4c
+{
+
+/// Per-event wall time and stack depth, and the slowest events for replay
+///
+/// The event starts in PrimaryGeneratorAction::GeneratePrimaries(), after
+/// the per-event seeding, and ends at the end of EventAction::
+/// EndOfEventAction(). In between, the StackingAction reports the number
+/// of tracks waiting in the stacks, whose peak is kept.
+///
+/// With /B4/timing/writeNtuple, the EventAction writes the wall time, the
+/// peak stack depth and the number of optical photons created of each
+/// event to the "Timing" ntuple.
+///
+/// With /B4/timing/slowEvents K, the state of the random engine at the
+/// start of each event is kept for the K slowest events of each thread.
+/// At the end of run the master prints the K slowest events of the run and
+/// writes their states to <prefix>_run<R>_event<N>.rndm
+/// (/B4/timing/slowPrefix, default "slow"). Such an event is replayed in
+/// isolation, with the same macro otherwise, by
+///   /B4/timing/replay slow_run0_event1234.rndm
+///   /run/beamOn 1
+/// which restores the state at the start of each event until
+/// /B4/timing/replay none. The replayed event has the event ID 0.
+///
+/// One instance per thread, accessed via Instance(), so that the commands
+/// exist on the master as well as on the workers.
+
+class EventTimer
+{
+  public:
+    static EventTimer* Instance();
+    ~EventTimer();
+
+    G4bool IsEnabled() const { return fWriteNtuple || fNofSlowEvents > 0; }
+    G4bool GetWriteNtuple() const { return fWriteNtuple; }
+
+    void BeginOfRun();
+    void BeginOfEvent();
+    void UpdateStackDepth(G4int depth)
+      { if ( depth > fPeakStackDepth ) fPeakStackDepth = depth; }
+    void EndOfEvent(G4int eventID, G4long nofPhotons);
+    void EndOfRun(G4bool isMaster, G4int runID);
+
+    // Values of the last ended event
+    G4double GetWallTime() const { return fWallTime; }
+    G4int GetPeakStackDepth() const { return fPeakStackDepth; }
+
+    struct SlowEvent
+    {
+      G4double wallTime = 0.;  ///< In seconds
+      G4int eventID = 0;
+      G4int threadID = 0;
+      G4int peakStackDepth = 0;
+      G4long nofPhotons = 0;
+      std::string randomState; ///< HepRandom::saveFullState()
+    };
+
+  private:
+    EventTimer();
+
+    void SetReplay(const G4String& fileName);
+    void WriteReport(G4int runID) const;
+
+    static G4ThreadLocal EventTimer* fgInstance;
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4bool fWriteNtuple = false;
+    G4int fNofSlowEvents = 0;
+    G4String fSlowPrefix = "slow";
+    std::string fReplayState;
+
+    std::chrono::steady_clock::time_point fStartTime;
+    std::string fRandomState;
+    G4double fWallTime = 0.;
+    G4int fPeakStackDepth = 0;
+
+    G4long fNofEvents = 0;
+    G4double fTotalWallTime = 0.;
+    std::vector<SlowEvent> fSlowEvents; // min-heap on the wall time
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
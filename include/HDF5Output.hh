@@ -0,0 +1,123 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file HDF5Output.hh
+/// \brief Definition of the B4c::HDF5Output class
+
+#ifndef B4cHDF5Output_h
+#define B4cHDF5Output_h 1
+
+#include "PhotonHit.hh"
+#include "globals.hh"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class G4GenericMessenger;
+
+namespace B4c
+{
+
+/// Writer of the detected photons to HDF5, bypassing the analysis manager
+///
+/// With /B4/output/photons hdf5, the RunAction opens one file per thread
+/// for the run: <fileName>.h5 in sequential mode, <fileName>_t<N>.h5 for
+/// each worker otherwise. The file has a group "B4" with one extendible,
+/// chunked dataset per column of the photon ntuple (see OutputSchema), so
+/// that the worker files can be read as they are or concatenated.
+///
+/// The EventAction adds the PhotonHits of the sensitive detectors. The
+/// rows are coalesced in memory and written by blocks of
+/// /B4/hdf5/bufferChunks chunks of /B4/hdf5/chunkRows rows. The full chunks
+/// are shuffled and deflated (/B4/hdf5/shuffle, /B4/hdf5/compression) on
+/// the calling thread and stored with direct chunk writes; only these
+/// writes are serialised between the threads, as the HDF5 library is.
+///
+/// Available when built with HDF5 (B4_WITH_HDF5); otherwise Open() fails
+/// with a warning and the photon ntuple is kept.
+///
+/// One instance per thread, accessed via Instance(), so that the commands
+/// exist on the master as well as on the workers.
+
+class HDF5Output
+{
+  public:
+    static HDF5Output* Instance();
+    static G4bool IsAvailable();
+    ~HDF5Output();
+
+    G4bool Open(const G4String& fileName);
+    void Close();
+    G4bool IsOpen() const { return fFile >= 0; }
+
+    void AddHits(G4int eventID, const PhotonHits& hits);
+
+    /// Number of rows added since Open(), written or buffered
+    std::size_t GetNofRows() const { return fNofRows + fNofBufferedRows; }
+
+  private:
+    HDF5Output();
+
+    struct Column
+    {
+      G4String name;
+      char type = 'D';            ///< 'D' (double) or 'I' (int), as the ntuple
+      std::size_t elementSize = 0;
+      std::vector<char> buffer;   ///< Rows not yet written
+      std::int64_t dataset = -1;  ///< HDF5 identifier
+    };
+
+    void Append(Column& column, G4double value);
+    void Flush(G4bool all);
+    void Failed(const char* what);
+
+    static G4ThreadLocal HDF5Output* fgInstance;
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4int fChunkRows = 65536;
+    G4int fBufferChunks = 4;
+    G4int fCompression = 1;
+    G4bool fShuffle = true;
+
+    G4String fFileName;
+    std::int64_t fFile = -1;   ///< HDF5 identifiers
+    std::int64_t fGroup = -1;
+    std::vector<Column> fColumns;
+    std::size_t fNofBufferedRows = 0;
+    std::size_t fNofRows = 0;  ///< Rows written to the datasets
+    std::size_t fOpenChunkRows = 0; ///< Settings of the open file
+    G4int fOpenCompression = 0;
+    G4bool fOpenShuffle = false;
+    std::vector<std::string> fChunks; ///< Scratch for the filtered chunks
+    std::string fShuffled;
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,96 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file HitPool.hh
+/// \brief Definition of the B4c::HitPool class template
+
+#ifndef B4cHitPool_h
+#define B4cHitPool_h 1
+
+#include "globals.hh"
+
+#include <algorithm>
+#include <vector>
+
+namespace B4c
+{
+
+/// Reusable contiguous hit storage
+///
+/// A per-thread replacement for a G4THitsCollection owned by the event:
+/// the hits are stored by value in one contiguous block which is kept
+/// from event to event. Reset() only forgets the hits, Add() reuses the
+/// storage and grows it geometrically when needed, so that once the
+/// largest event has been seen no more heap allocation takes place.
+/// GetNofGrowths() counts the reallocations, for the allocation report.
+
+template <typename T>
+class HitPool
+{
+  public:
+    HitPool() = default;
+
+    void Reset() { fSize = 0; }
+
+    T& Add(const T& hit = T())
+    {
+      if ( fSize == fHits.size() ) Grow();
+      fHits[fSize] = hit;
+      return fHits[fSize++];
+    }
+
+    void Reserve(std::size_t capacity)
+    {
+      if ( capacity > fHits.size() ) fHits.resize(capacity);
+    }
+
+    std::size_t GetSize() const { return fSize; }
+    std::size_t GetCapacity() const { return fHits.size(); }
+    G4long GetNofGrowths() const { return fNofGrowths; }
+
+    T& operator[](std::size_t i) { return fHits[i]; }
+    const T& operator[](std::size_t i) const { return fHits[i]; }
+
+    const T* begin() const { return fHits.data(); }
+    const T* end() const { return fHits.data() + fSize; }
+
+  private:
+    void Grow()
+    {
+      fHits.resize(std::max<std::size_t>(64, 2*fHits.size()));
+      ++fNofGrowths;
+    }
+
+    std::vector<T> fHits;
+    std::size_t fSize = 0;
+    G4long fNofGrowths = 0;
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,106 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file KillZone.hh
+/// \brief Definition of the B4c::KillZone class
+
+#ifndef B4cKillZone_h
+#define B4cKillZone_h 1
+
+#include "G4Accumulable.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <array>
+
+class G4GenericMessenger;
+class G4LogicalVolume;
+class G4Track;
+class G4VPhysicalVolume;
+
+namespace B4c
+{
+
+/// Geometric kill zone for the tracks leaving the black box
+///
+/// With /B4/killzone/enable, every track other than a primary, a muon or
+/// an optical photon is killed in the world volume outside the black box
+/// ("logicWorld"), or only outside an envelope box centred at
+/// /B4/killzone/centre with half-lengths /B4/killzone/envelope (default
+/// 0: no envelope) if one is given. The envelope can only keep tracks
+/// outside the black box, not kill tracks inside it.
+///
+/// The test costs nothing inside the box: a track is killed at the end of
+/// its first step outside by the KillZoneSD attached to the world volume,
+/// and a track created outside by the StackingAction. The optical photons
+/// are left to the wall surfaces and the PhotonCounters.
+///
+/// The killed tracks and their kinetic energy are counted per particle
+/// type in G4Accumulables registered on the thread; Print() is called on
+/// the master at the end of the run.
+///
+/// One instance per thread, accessed via Instance(), so that the commands
+/// exist on the master as well as on the workers.
+
+class KillZone
+{
+  public:
+    enum Category { kGamma, kNeutron, kElectron, kOther, kNofCategories };
+
+    static KillZone* Instance();
+    ~KillZone();
+
+    G4bool IsEnabled() const { return fEnabled; }
+
+    // Whether the track, at its current position in the given volume,
+    // is to be killed
+    G4bool IsToBeKilled(const G4Track* track,
+                        const G4VPhysicalVolume* volume) const;
+    void Add(const G4Track* track);
+
+    void Print() const;
+
+  private:
+    KillZone();
+
+    static G4ThreadLocal KillZone* fgInstance;
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4bool fEnabled = false;
+    G4ThreeVector fCentre;
+    G4ThreeVector fEnvelope;
+
+    mutable const G4LogicalVolume* fWorldVolume = nullptr;
+
+    std::array<G4Accumulable<G4long>, kNofCategories> fNofKilled;
+    std::array<G4Accumulable<G4double>, kNofCategories> fEnergy;
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
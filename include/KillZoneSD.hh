@@ -0,0 +1,64 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file KillZoneSD.hh
+/// \brief Definition of the B4c::KillZoneSD class
+
+#ifndef B4cKillZoneSD_h
+#define B4cKillZoneSD_h 1
+
+#include "G4VSensitiveDetector.hh"
+
+class G4Step;
+class G4HCofThisEvent;
+
+namespace B4c
+{
+
+class KillZone;
+
+/// Sensitive detector of the world volume outside the black box
+///
+/// ProcessHits() kills the tracks which the KillZone selects at the end
+/// of their step, and counts them. It records no hits.
+
+class KillZoneSD : public G4VSensitiveDetector
+{
+  public:
+    explicit KillZoneSD(const G4String& name);
+    ~KillZoneSD() override = default;
+
+    G4bool ProcessHits(G4Step* step, G4TouchableHistory* history) override;
+
+  private:
+    KillZone* fKillZone = nullptr;
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,135 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file LazyPhotons.hh
+/// \brief Definition of the B4c::LazyPhotons class
+
+#ifndef B4cLazyPhotons_h
+#define B4cLazyPhotons_h 1
+
+#include "G4ThreeVector.hh"
+#include "G4TouchableHandle.hh"
+#include "G4TrackVector.hh"
+#include "globals.hh"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+class G4Cerenkov;
+class G4GenericMessenger;
+class G4Material;
+class G4ParticleDefinition;
+class G4Scintillation;
+class G4Step;
+
+namespace B4c
+{
+
+/// Lazy generation of the optical photons
+///
+/// With /B4/lazy/enable true (before /run/initialize), the scintillation
+/// and Cerenkov processes no longer stack their photons. Instead, the
+/// stepping action records, for each step of a charged particle which
+/// would have emitted photons, one compact EmissionRecord: the step
+/// segment, the photon count, the particle velocities and the material.
+/// When the urgent stack is empty, StackingAction::NewStage() calls
+/// Materialise(), which samples at most /B4/lazy/batch photons from the
+/// pending records, the same way as the processes would have done, and
+/// pushes them on the stack. The number of optical photon tracks alive
+/// at the same time is thus bounded by the batch size.
+///
+/// The photons of the last recorded step are materialised first, so that
+/// the tracking order is close to the one of TrackSecondariesFirst.
+/// G4ScintillationTrackInformation is not attached to the lazy photons.
+/// No record is made for a source disabled in the volume of the step
+/// (see PhotonSources).
+///
+/// One instance per thread, accessed via Instance(), so that the commands
+/// exist on the master as well as on the workers.
+
+class LazyPhotons
+{
+  public:
+    struct EmissionRecord {
+      G4ThreeVector start;
+      G4ThreeVector end;
+      G4double startTime = 0.;
+      G4double startVelocity = 0.;
+      G4double endVelocity = 0.;
+      // Cerenkov only: 1/beta and mean photon yields at both step ends
+      G4double betaInverse = 0.;
+      G4double meanPhotons1 = 0.;
+      G4double meanPhotons2 = 0.;
+      const G4Material* material = nullptr;
+      G4TouchableHandle touchable;
+      G4int parentID = 0;
+      G4int nofPhotons = 0;
+      G4bool cerenkov = false;
+    };
+
+    static LazyPhotons* Instance();
+    ~LazyPhotons();
+
+    G4bool IsEnabled() const { return fEnabled; }
+    void SetEnabled(G4bool enabled);
+
+    void Clear();
+    void RecordStep(const G4Step* step);
+    G4int Materialise();
+
+    std::size_t GetNofPendingRecords() const { return fRecords.size(); }
+
+  private:
+    LazyPhotons();
+
+    void FindProcesses();
+    std::pair<G4bool, G4bool> GetActivation(const G4ParticleDefinition*);
+    void SampleScintillation(const EmissionRecord& record, G4int nofPhotons);
+    void SampleCerenkov(const EmissionRecord& record, G4int nofPhotons);
+
+    static G4ThreadLocal LazyPhotons* fgInstance;
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4bool fEnabled = false;
+    G4int fBatchSize = 1000;
+
+    G4bool fProcessesFound = false;
+    G4Scintillation* fScintillation = nullptr;
+    G4Cerenkov* fCerenkov = nullptr;
+    // (scintillation, Cerenkov) active for a particle type
+    std::map<const G4ParticleDefinition*, std::pair<G4bool, G4bool>>
+      fActivation;
+
+    std::vector<EmissionRecord> fRecords;
+    G4TrackVector fBatch;
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,89 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file OutputSchema.hh
+/// \brief Definition of the histogram and ntuple layout of the B4c output
+
+#ifndef B4cOutputSchema_h
+#define B4cOutputSchema_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+namespace B4c
+{
+
+/// Ntuple column description, type is 'I' (G4int) or 'D' (G4double)
+struct NtupleColumn
+{
+  G4String name;
+  char type;
+};
+
+/// Ntuple description; the position in GetNtupleSchemas() is the ntuple ID
+struct NtupleSchema
+{
+  G4String name;
+  G4String title;
+  std::vector<NtupleColumn> columns;
+};
+
+/// H1 histogram description; the position in GetH1Schemas() is the H1 ID
+struct H1Schema
+{
+  G4String name;
+  G4String title;
+  G4int nbins;
+  G4double xmin;
+  G4double xmax;
+};
+
+/// The histograms written by the simulation
+const std::vector<H1Schema>& GetH1Schemas();
+
+/// The ntuples written by the simulation:
+/// - 0 "B4": one row per recorded optical photon
+/// - 1 "Event": per-event summary
+/// - 2 "PMT": PMT digitisation summary
+/// - 3 "Budget": per-event photon budget
+/// - 4 "Timing": per-event wall time (s), peak stack depth and optical
+///   photons created (see EventTimer)
+/// Shared by the RunAction and the offline tools so that they agree on
+/// the layout.
+const std::vector<NtupleSchema>& GetNtupleSchemas();
+
+/// Book all the histograms of GetH1Schemas() with the analysis manager
+void CreateHistograms();
+
+/// Book all the ntuples of GetNtupleSchemas() with the analysis manager
+void CreateNtuples();
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,119 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file PMTDigi.hh
+/// \brief Definition of the B4c::PMTDigi class
+
+#ifndef B4cPMTDigi_h
+#define B4cPMTDigi_h 1
+
+#include "G4VDigi.hh"
+#include "G4TDigiCollection.hh"
+#include "G4Allocator.hh"
+#include "G4Threading.hh"
+#include "globals.hh"
+
+#include <vector>
+
+namespace B4c
+{
+
+/// PMT digit class
+///
+/// It holds the sampled waveform of one PMT for one event as compact
+/// 16-bit ADC counts, together with the threshold-crossing summary:
+/// - fTrace: ADC samples (only filled in trace output mode)
+/// - fNofPhotoElectrons, fCrossingTime, fPeak, fCharge
+
+class PMTDigi : public G4VDigi
+{
+  public:
+    PMTDigi() = default;
+    PMTDigi(const PMTDigi&) = default;
+    ~PMTDigi() override = default;
+
+    // operators
+    PMTDigi& operator=(const PMTDigi&) = default;
+    G4bool operator==(const PMTDigi&) const;
+
+    inline void* operator new(size_t);
+    inline void  operator delete(void*);
+
+    // methods from base class
+    void Draw()  override{}
+    void Print() override;
+
+    // set methods
+    void SetNofPhotoElectrons(G4int n) { fNofPhotoElectrons = n; }
+    void SetCrossingTime(G4double t) { fCrossingTime = t; }
+    void SetPeak(G4int peak) { fPeak = peak; }
+    void SetCharge(G4double charge) { fCharge = charge; }
+    std::vector<G4short>& GetTrace() { return fTrace; }
+
+    // get methods
+    G4int GetNofPhotoElectrons() const { return fNofPhotoElectrons; }
+    G4double GetCrossingTime() const { return fCrossingTime; }
+    G4int GetPeak() const { return fPeak; }
+    G4double GetCharge() const { return fCharge; }
+    const std::vector<G4short>& GetTrace() const { return fTrace; }
+
+  private:
+    std::vector<G4short> fTrace;     ///< ADC samples
+    G4int fNofPhotoElectrons = 0;    ///< Number of digitised photoelectrons
+    G4double fCrossingTime = -1.;    ///< First threshold crossing, <0 if none
+    G4int fPeak = 0;                 ///< Maximum sample in ADC counts
+    G4double fCharge = 0.;           ///< Sum of samples in ADC counts
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+using PMTDigitsCollection = G4TDigiCollection<PMTDigi>;
+
+extern G4ThreadLocal G4Allocator<PMTDigi>* PMTDigiAllocator;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline void* PMTDigi::operator new(size_t)
+{
+  if (!PMTDigiAllocator) {
+    PMTDigiAllocator = new G4Allocator<PMTDigi>;
+  }
+  return (void *) PMTDigiAllocator->MallocSingle();
+}
+
+inline void PMTDigi::operator delete(void *digi)
+{
+  if (!PMTDigiAllocator) {
+    PMTDigiAllocator = new G4Allocator<PMTDigi>;
+  }
+  PMTDigiAllocator->FreeSingle((PMTDigi*) digi);
+}
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,152 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file PerfCounters.hh
+/// \brief Definition of the B4c::PerfCounters class
+
+#ifndef B4cPerfCounters_h
+#define B4cPerfCounters_h 1
+
+#include "globals.hh"
+
+#include <array>
+#include <cstdint>
+
+class G4GenericMessenger;
+
+namespace B4c
+{
+
+/// Hardware performance counters per run phase (Linux perf_event_open)
+///
+/// With /B4/perf/enable, each thread opens a group of counters on itself
+/// (user space only): cycles, instructions, cache misses and branch
+/// misses. The counts are accumulated over the phases:
+/// - kInitialisation: from the enable command to the first run, i.e. the
+///   geometry and physics initialisation when the command precedes
+///   /run/initialize,
+/// - kGeneratePrimaries: PrimaryGeneratorAction::GeneratePrimaries(),
+/// - kTracking: between the begin and end of event actions,
+/// - kProcessHits: CalorimeterSD::ProcessHits(), within kTracking,
+/// - kEndOfEvent: EventAction::EndOfEventAction(),
+/// - kOutput: the photon output of the events, within kEndOfEvent, and the
+///   writing of the files at the end of run.
+/// Each counter read is a system call: kProcessHits, entered once per step
+/// in the sensitive volumes, carries its overhead.
+///
+/// At the end of run each thread adds its counts to a shared report, which
+/// the master prints and, with /B4/perf/json, writes to <prefix>_run<N>.json
+/// per thread and summed. The counts are scaled when the kernel multiplexes
+/// the counters. Counters which cannot be opened, e.g. in a virtual machine
+/// or with a restrictive perf_event_paranoid, are reported as missing.
+///
+/// One instance per thread, accessed via Instance().
+
+class PerfCounters
+{
+  public:
+    enum Phase {
+      kInitialisation,
+      kGeneratePrimaries,
+      kTracking,
+      kProcessHits,
+      kEndOfEvent,
+      kOutput,
+      kNofPhases
+    };
+    enum Counter {
+      kCycles,
+      kInstructions,
+      kCacheMisses,
+      kBranchMisses,
+      kNofCounters
+    };
+
+    /// Counts the enclosing block in the given phase
+    class Scope
+    {
+      public:
+        explicit Scope(Phase phase)
+          : fPhase(phase) { Instance()->Start(fPhase); }
+        ~Scope() { Instance()->Stop(fPhase); }
+
+      private:
+        Phase fPhase;
+    };
+
+    static PerfCounters* Instance();
+    ~PerfCounters();
+
+    static const char* GetName(Phase phase);
+    static const char* GetName(Counter counter);
+
+    G4bool IsActive() const { return fGroup >= 0; }
+
+    void Start(Phase phase) { if ( IsActive() ) Read(fStart[phase]); }
+    void Stop(Phase phase) { if ( IsActive() ) Accumulate(phase); }
+
+    void BeginOfRun();
+    void EndOfRun(G4bool isMaster, G4int runID);
+
+  private:
+    PerfCounters();
+
+    struct Sample {
+      std::array<std::uint64_t, kNofCounters> values = {};
+      std::uint64_t enabled = 0; // time the group was enabled, running
+      std::uint64_t running = 0;
+    };
+    struct Totals {
+      std::uint64_t calls = 0;
+      std::array<G4double, kNofCounters> values = {};
+    };
+
+    void SetEnabled(G4bool enabled);
+    void Open();
+    void Close();
+    void Read(Sample& sample) const;
+    void Accumulate(Phase phase);
+
+    static G4ThreadLocal PerfCounters* fgInstance;
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4String fJsonPrefix;
+
+    G4int fGroup = -1; // file descriptor of the group leader (cycles)
+    std::array<G4int, kNofCounters> fDescriptors;
+    std::array<G4int, kNofCounters> fSlots; // position in the group read
+    G4int fNofOpen = 0;
+    G4bool fInitialising = false;
+
+    std::array<Sample, kNofPhases> fStart;
+    std::array<Totals, kNofPhases> fTotals;
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,82 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file Photocathode.hh
+/// \brief Definition of the B4c::Photocathode class
+
+#ifndef B4cPhotocathode_h
+#define B4cPhotocathode_h 1
+
+#include "G4MaterialPropertyVector.hh"
+#include "globals.hh"
+
+class G4GenericMessenger;
+
+namespace B4c
+{
+
+/// PMT photocathode model
+///
+/// It decides whether an optical photon absorbed in the PMT glass produces
+/// a photoelectron. The photon first passes the quantum efficiency, sampled
+/// from a QE spectrum (a typical bialkali curve by default), then the
+/// collection efficiency of the first dynode.
+///
+/// The model is owned by the DetectorConstruction and shared read-only by
+/// the worker threads. It is configured via the /B4/pmt/ commands and is
+/// disabled by default, in which case every photon is accepted.
+
+class Photocathode
+{
+  public:
+    /// Outcome of Sample(), ordered by the stage reached
+    enum Stage { kFailedQE, kFailedCE, kDetected };
+
+    Photocathode();
+    ~Photocathode();
+
+    Stage Sample(G4double photonEnergy) const;
+
+    G4bool IsEnabled() const { return fEnabled; }
+    G4double GetQuantumEfficiency(G4double photonEnergy) const;
+
+  private:
+    void DefineCommands();
+    void ReadQEFile(const G4String& fileName);
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4MaterialPropertyVector* fQE = nullptr;
+
+    G4bool   fEnabled = false;
+    G4double fQEScale = 1.;
+    G4double fCollectionEfficiency = 1.;
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,118 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file PhotonCodec.hh
+/// \brief Definition of the compact photon encoding of the B4c output
+
+#ifndef B4cPhotonCodec_h
+#define B4cPhotonCodec_h 1
+
+#include "G4SystemOfUnits.hh"
+#include "globals.hh"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace B4c
+{
+
+/// One detected photon of the compact output
+struct CompactPhoton
+{
+  G4double wavelength = 0.; ///< nm
+  G4double time = 0.;       ///< relative to the event (primary vertex) time
+  G4int creator = 0;        ///< PhotonSources::Creator
+};
+
+/// Compact encoding of the detected photons (.b4p files)
+///
+/// The file starts with the 4 bytes "B4P" 0x01, followed by one record
+/// per event, photons or not:
+/// - event ID and number of photons, as unsigned LEB128 varints,
+/// - per photon, in increasing time order:
+///   - wavelength, uint16 little endian, in 0.01 nm steps from 100 nm,
+///   - time, as the varint difference with the previous photon of the
+///     event (the first one: with the event time) in 1 ps steps, the
+///     times being quantised before the differences are taken,
+///   - creator, one byte.
+///
+/// A photon thus takes 4 to 8 bytes instead of the 8 bytes of each double
+/// column of the "B4" ntuple. The quantisation error is at most
+/// kMaxWavelengthError = 0.005 nm and kMaxTimeError = 0.5 ps within the
+/// encoded ranges, 100 to 755.35 nm and 0 to 4.29 ms after the event
+/// time; the values outside are clamped to the range. The path lengths are
+/// not encoded: the absorption reweighting needs the ntuple output.
+///
+/// The encoding is shared by the simulation (CompactOutput) and the
+/// offline tools (b4decode, b4analysis).
+
+class PhotonCodec
+{
+  public:
+    static constexpr G4double kWavelengthOffset = 100.;  // nm
+    static constexpr G4double kWavelengthStep = 0.01;    // nm
+    static constexpr G4double kTimeStep = 1.*picosecond;
+    static constexpr G4double kMaxWavelengthError = kWavelengthStep / 2.;
+    static constexpr G4double kMaxTimeError = kTimeStep / 2.;
+
+    static const std::string& GetMagic();
+
+    /// Appends the record of an event to the buffer; the photons are
+    /// sorted by time
+    static void EncodeEvent(G4int eventID, std::vector<CompactPhoton>& photons,
+                            std::string& buffer);
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Sequential reader of a .b4p file
+
+class PhotonDecoder
+{
+  public:
+    /// Opens the file and checks its header
+    G4bool Open(const G4String& fileName);
+
+    /// Reads the next event; false at the end of the file or if the
+    /// record is truncated (see IsCorrupted())
+    G4bool ReadEvent(G4int& eventID, std::vector<CompactPhoton>& photons);
+
+    G4bool IsCorrupted() const { return fCorrupted; }
+
+  private:
+    G4bool ReadVarint(std::uint64_t& value);
+
+    std::ifstream fFile;
+    G4bool fCorrupted = false;
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,125 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file PhotonCounters.hh
+/// \brief Definition of the B4c::PhotonCounters class
+
+#ifndef B4cPhotonCounters_h
+#define B4cPhotonCounters_h 1
+
+#include "G4Accumulable.hh"
+#include "globals.hh"
+
+#include <array>
+
+class G4GenericMessenger;
+class G4LogicalVolume;
+class G4Track;
+
+namespace B4c
+{
+
+/// Optical photon bookkeeping counters
+///
+/// One instance per thread, accessed via Instance(). Each counter is kept
+/// twice: as a G4Accumulable for the run, registered with the
+/// G4AccumulableManager of the thread so that it is reset and merged by the
+/// RunAction, and as a plain per-event value reset in BeginOfEvent().
+///
+/// The counters follow a photon from its creation (by process and volume)
+/// to its fate: absorbed (by volume or at the black box walls and
+/// stand), escaped from the world, killed below 300 nm, culled by the
+/// TimeGate, suppressed by the PhotonSources switches, or accepted by the
+/// photocathode stages (reached the PMT, passed the quantum efficiency,
+/// passed the collection efficiency = detected).
+/// kRecorded counts the rows written to the photon ntuple by all the
+/// sensitive detectors.
+///
+/// Print() prints the photon budget table; it is meant to be called on the
+/// master after the merge. The static overload prints the table for values
+/// accumulated elsewhere, e.g. over the segments of a checkpointed run.
+/// With /B4/budget/writeNtuple the per-event values are also written to
+/// the "Budget" ntuple.
+
+class PhotonCounters
+{
+  public:
+    enum Counter {
+      kCreatedScintQD, kCreatedScintBottle, kCreatedScintOther,
+      kCreatedCerenkovQD, kCreatedCerenkovBottle, kCreatedCerenkovOther,
+      kCreatedOther,
+      kAbsorbedQD, kAbsorbedBottle, kAbsorbedPMT, kAbsorbedOther,
+      kAbsorbedWall,
+      kEscaped, kBelowCutoff, kCulled, kSuppressed,
+      kReachedPMT, kPassedQE, kDetected,
+      kRecorded,
+      kNofCounters
+    };
+
+    enum Location { kQD, kBottle, kPMT, kElsewhere };
+
+    static PhotonCounters* Instance();
+    ~PhotonCounters();
+
+    void Add(Counter counter) { fRun[counter] += 1; ++fEvent[counter]; }
+    void AddCreated(const G4Track* track);
+    void AddAbsorbed(const G4LogicalVolume* volume);
+
+    Location Locate(const G4LogicalVolume* volume);
+
+    void BeginOfEvent() { fEvent.fill(0); }
+
+    G4long GetRunValue(Counter counter) const
+      { return fRun[counter].GetValue(); }
+    G4long GetEventValue(Counter counter) const { return fEvent[counter]; }
+    static const char* GetName(Counter counter);
+
+    G4bool GetWriteNtuple() const { return fWriteNtuple; }
+
+    void Print() const;
+    static void Print(const std::array<G4long, kNofCounters>& values);
+
+  private:
+    PhotonCounters();
+
+    static G4ThreadLocal PhotonCounters* fgInstance;
+
+    std::array<G4Accumulable<G4long>, kNofCounters> fRun;
+    std::array<G4long, kNofCounters> fEvent = {};
+
+    const G4LogicalVolume* fQDVolume = nullptr;
+    const G4LogicalVolume* fBottleVolume = nullptr;
+    const G4LogicalVolume* fPMTVolume = nullptr;
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4bool fWriteNtuple = false;
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
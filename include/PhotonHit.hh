@@ -0,0 +1,104 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file PhotonHit.hh
+/// \brief Definition of the B4c::PhotonHit class
+
+#ifndef B4cPhotonHit_h
+#define B4cPhotonHit_h 1
+
+#include "HitPool.hh"
+#include "PhotonSources.hh"
+#include "PhotonTrackInfo.hh"
+#include "globals.hh"
+
+namespace B4c
+{
+
+/// Detected optical photon hit class
+///
+/// One hit is recorded per optical photon accepted by a CalorimeterSD.
+/// It keeps the photon arrival time and wavelength, which are the inputs
+/// of the PMT digitisation:
+/// - fTime, fWavelength
+/// and its path lengths per material, for the absorption reweighting:
+/// - fPathLengths (see PhotonTrackInfo)
+/// and the process which created it:
+/// - fCreator (see PhotonSources)
+///
+/// The hits are plain values stored contiguously in a PhotonHits pool
+/// owned by the sensitive detector and reused from event to event.
+
+class PhotonHit
+{
+  public:
+    PhotonHit() = default;
+    PhotonHit(G4double time, G4double wavelength,
+              const PhotonTrackInfo::PathLengths& pathLengths = {},
+              PhotonSources::Creator creator = PhotonSources::kOther);
+
+    void Print() const;
+
+    // get methods
+    G4double GetTime() const;
+    G4double GetWavelength() const;
+    const PhotonTrackInfo::PathLengths& GetPathLengths() const;
+    PhotonSources::Creator GetCreator() const;
+
+  private:
+    G4double fTime = 0.;       ///< Global arrival time of the photon
+    G4double fWavelength = 0.; ///< Photon wavelength in nm
+    PhotonTrackInfo::PathLengths fPathLengths = {}; ///< Per material
+    PhotonSources::Creator fCreator = PhotonSources::kOther;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+using PhotonHits = HitPool<PhotonHit>;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline G4double PhotonHit::GetTime() const {
+  return fTime;
+}
+
+inline G4double PhotonHit::GetWavelength() const {
+  return fWavelength;
+}
+
+inline const PhotonTrackInfo::PathLengths& PhotonHit::GetPathLengths() const {
+  return fPathLengths;
+}
+
+inline PhotonSources::Creator PhotonHit::GetCreator() const {
+  return fCreator;
+}
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,122 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file PhotonSources.hh
+/// \brief Definition of the B4c::PhotonSources class
+
+#ifndef B4cPhotonSources_h
+#define B4cPhotonSources_h 1
+
+#include "globals.hh"
+
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+class G4GenericMessenger;
+class G4LogicalVolume;
+class G4Track;
+
+namespace B4c
+{
+
+/// Per-volume switches of the optical photon sources
+///
+/// The /B4/sources/ commands turn the scintillation or Cerenkov photons
+/// off (and on again) in a logical volume given by name, or in every
+/// volume with "all":
+/// - disableScintillation, enableScintillation <volume>
+/// - disableCerenkov, enableCerenkov <volume>
+/// - list
+///
+/// The last command for a volume wins over "all": after disable... all,
+/// enable... <volume> keeps the photons of that volume only. A volume
+/// name that matches no logical volume is reported with a warning, once
+/// the geometry is built.
+///
+/// A photon created in a disabled volume is killed by the StackingAction
+/// before it is transported, and counted by the PhotonCounters as created
+/// and suppressed (kSuppressed). With /B4/lazy/enable the LazyPhotons do
+/// not even record its emission, so it is neither generated nor counted.
+///
+/// GetCreator() gives the compact creator tag written with each detected
+/// photon ("Creator" column of the photon ntuple).
+///
+/// One instance per thread, accessed via Instance(), so that the commands
+/// exist on the master as well as on the workers.
+
+class PhotonSources
+{
+  public:
+    enum Creator { kOther = 0, kScintillation = 1, kCerenkov = 2 };
+
+    static PhotonSources* Instance();
+    ~PhotonSources();
+
+    static Creator GetCreator(const G4Track* track);
+
+    G4bool IsEnabled(Creator creator, const G4LogicalVolume* volume);
+
+  private:
+    PhotonSources();
+
+    void DisableScintillation(const G4String& volume);
+    void EnableScintillation(const G4String& volume);
+    void DisableCerenkov(const G4String& volume);
+    void EnableCerenkov(const G4String& volume);
+    // State of one source: off in all volumes or not, and the volumes
+    // where it is switched the other way
+    struct Switches
+    {
+      G4bool disabledInAll = false;
+      std::set<G4String> exceptions;
+
+      G4bool IsEnabled(const G4LogicalVolume* volume) const;
+      G4bool IsRestricted() const
+        { return disabledInAll || ! exceptions.empty(); }
+    };
+
+    void Set(Switches& switches, const G4String& volume, G4bool enabled);
+    void CheckVolumes();
+    void List();
+
+    static G4ThreadLocal PhotonSources* fgInstance;
+
+    G4GenericMessenger* fMessenger = nullptr;
+    Switches fScintillationSwitches;
+    Switches fCerenkovSwitches;
+    std::set<G4String> fUncheckedVolumes;  // until the geometry is built
+
+    // (scintillation, Cerenkov) enabled, per volume met so far
+    std::unordered_map<const G4LogicalVolume*, std::pair<G4bool, G4bool>>
+      fCache;
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,116 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file PhotonTrackInfo.hh
+/// \brief Definition of the B4c::PhotonTrackInfo class
+
+#ifndef B4cPhotonTrackInfo_h
+#define B4cPhotonTrackInfo_h 1
+
+#include "G4Allocator.hh"
+#include "G4VUserTrackInformation.hh"
+#include "globals.hh"
+
+#include <array>
+
+class G4Track;
+
+namespace B4c
+{
+
+/// Optical photon path lengths per material
+///
+/// Attached to each optical photon by the StackingAction, with Attach(),
+/// when the photon is classified. The stepping action adds the length of
+/// every step to the region of its pre-step volume: the QD, the Bottle
+/// glass or the air (any other volume outside the PMT). The path
+/// lengths of a detected photon are copied to its PhotonHit and written to
+/// the "B4" ntuple (PathQD, PathBottle, PathAir), so that its detection
+/// weight can be recomputed for another absorption length spectrum:
+///   w = exp(-sum_r L_r * (1/lambda'_r(E) - 1/lambda_r(E)))
+/// see b4analysis --reweight.
+///
+/// A photon has a single user track information: Attach() replaces the
+/// G4ScintillationTrackInformation set by the scintillation process
+/// (SetScintTrackInfo) and keeps its scintillation type.
+
+class PhotonTrackInfo : public G4VUserTrackInformation
+{
+  public:
+    enum Path { kPathQD, kPathBottle, kPathAir, kNofPaths };
+    using PathLengths = std::array<G4double, kNofPaths>;
+
+    PhotonTrackInfo() = default;
+    ~PhotonTrackInfo() override = default;
+
+    inline void* operator new(size_t);
+    inline void  operator delete(void*);
+
+    void AddPathLength(Path path, G4double length)
+      { fPathLengths[path] += length; }
+    const PathLengths& GetPathLengths() const { return fPathLengths; }
+
+    /// Scintillation component of the photon, -1 if unknown
+    G4int GetScintillationType() const { return fScintillationType; }
+
+    /// The info of the track, attached first if the track has none or
+    /// another user track information
+    static PhotonTrackInfo* Attach(const G4Track* track);
+
+    static const char* GetName(Path path);
+
+  private:
+    PathLengths fPathLengths = {};
+    G4int fScintillationType = -1;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+extern G4ThreadLocal G4Allocator<PhotonTrackInfo>* PhotonTrackInfoAllocator;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline void* PhotonTrackInfo::operator new(size_t)
+{
+  if (!PhotonTrackInfoAllocator) {
+    PhotonTrackInfoAllocator = new G4Allocator<PhotonTrackInfo>;
+  }
+  return (void *) PhotonTrackInfoAllocator->MallocSingle();
+}
+
+inline void PhotonTrackInfo::operator delete(void *info)
+{
+  if (!PhotonTrackInfoAllocator) {
+    PhotonTrackInfoAllocator = new G4Allocator<PhotonTrackInfo>;
+  }
+  PhotonTrackInfoAllocator->FreeSingle((PhotonTrackInfo*) info);
+}
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -33,7 +33,10 @@
 #include "G4UserRunAction.hh"
 #include "globals.hh"
 
+#include <chrono>
+
 class G4Run;
+class G4GenericMessenger;
 
 namespace B4
 {
@@ -53,7 +56,19 @@ namespace B4
 /// according to a specified file extension.
 ///
 /// In EndOfRunAction(), the accumulated statistic and computed
-/// dispersion is printed.
+/// dispersion is printed, together with the PhotonCounters merged
+/// from all threads. The master also prints a one-line timing summary
+/// (number of events, initialisation time, event loop time) which the
+/// benchmark scripts parse.
+///
+/// The /B4/output/ commands select the output file name and type and the
+/// sharded mode, in which each worker writes its ntuples to its own
+/// <fileName>_t<N>.root file instead of sending them to the master.
+/// The shards are combined offline with the b4merge tool.
+///
+/// /B4/output/photons selects the output of the detected photons: the
+/// "B4" ntuple (default), the compact encoding of B4c::PhotonCodec in
+/// <fileName>[_t<N>].b4p files (written by B4c::CompactOutput), or both.
 ///
 
 class RunAction : public G4UserRunAction
@@ -64,6 +79,27 @@ class RunAction : public G4UserRunAction
 
     void BeginOfRunAction(const G4Run*) override;
     void   EndOfRunAction(const G4Run*) override;
+
+    /// Output file of the next (or last) run, with its extension
+    G4String GetFileName() const { return fFileName + "." + fFileType; }
+
+    /// Whether the workers write their ntuples to their own files
+    G4bool IsSharded() const { return fSharded; }
+
+  private:
+    void DefineCommands();
+
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point fCreationTime = Clock::now(); ///< start of the job
+    Clock::time_point fRunStartTime;
+    G4double fInitTime = -1.; ///< seconds until the first run started
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4String fFileName = "B4";
+    G4String fFileType = "root";
+    G4bool fSharded = false;
+    G4String fPhotonFormat = "ntuple";
 };
  
 }
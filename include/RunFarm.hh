@@ -0,0 +1,100 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file RunFarm.hh
+/// \brief Definition of the B4c::RunFarm class
+
+#ifndef B4cRunFarm_h
+#define B4cRunFarm_h 1
+
+#include "globals.hh"
+
+#include <atomic>
+
+class G4GenericMessenger;
+
+namespace B4c
+{
+
+/// Local multi-process run farm
+///
+/// "exampleB4c -j N -m macro [-t nThreads]" does not run the macro
+/// itself: Launch() forks N independent exampleB4c processes (shards),
+/// each started with "-p k:N" and its output redirected to farm_p<k>.log.
+/// The shards merge their worker ntuples (/B4/output/sharded is switched
+/// off).
+/// A shard executes a copy of the macro in which /run/beamOn is replaced
+/// by /B4/farm/beamOn: of the N events of each run, shard k processes the
+/// k-th contiguous range, with the event IDs of that range (see
+/// Checkpoint::GetEventOffset()), and writes <output>_p<k>.root, where
+/// <output> is set with /B4/farm/output (default B4). Per-event seeding
+/// (see EventSeeder) is switched on in the shards, so that the random
+/// streams of the shards are disjoint and the farm result does not depend
+/// on the number of processes. Only the top-level macro is rewritten: a
+/// /run/beamOn in a nested macro would run all its events in every shard.
+///
+/// The shards report their progress and output files on a pipe; the
+/// launcher prints the progress of each shard, restarts a shard which
+/// crashed or failed up to twice, appending to its log so that the output
+/// of the failed attempt is kept, and when all shards are done, merges
+/// the ROOT outputs of each run with b4merge into <output>.root.
+
+class RunFarm
+{
+  public:
+    /// Shard side: "k:N" as given with -p
+    explicit RunFarm(const G4String& shard);
+    ~RunFarm();
+
+    /// Launcher side: runs the whole farm, returns the exit code
+    static G4int Launch(G4int argc, char** argv, G4int nofProcesses);
+
+    /// Writes the shard macro, returns its name
+    G4String PrepareMacro(const G4String& macro) const;
+
+    /// Called at the end of each event on any thread of a shard
+    static void EndOfEvent();
+
+  private:
+    void BeamOn(G4int nofEvents);
+    void DefineCommands();
+    static void Report(const G4String& line);
+
+    static G4int fgProgressFd;
+    static std::atomic<G4long> fgEventsDone;
+    static G4long fgEventsToDo;
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4int fShard = 0;
+    G4int fNofShards = 1;
+    G4String fOutputName = "B4";
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,161 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file RunMonitor.hh
+/// \brief Definition of the B4c::RunMonitor class
+
+#ifndef B4cRunMonitor_h
+#define B4cRunMonitor_h 1
+
+#include "globals.hh"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class G4GenericMessenger;
+
+namespace B4c
+{
+
+/// Live run monitoring
+///
+/// /B4/monitor/start launches a monitoring thread on the master which,
+/// every /B4/monitor/interval, takes a snapshot of the per-thread
+/// histograms (photons recorded per event, photon time, photon wavelength)
+/// and counters, computes the event and photon rates and serves the last
+/// snapshot as JSON, either over HTTP on 127.0.0.1:<port> or, if
+/// /B4/monitor/socket is set, on a Unix domain socket (e.g.
+/// "curl localhost:8080" or "nc -U B4.sock").
+///
+/// Each thread fills its own ThreadData: photons are staged during the
+/// event in plain arrays, and at the end of the event added to the
+/// active one of two slots. A snapshot flips the active slot of each
+/// thread (the epoch), waits until the thread is no longer writing the
+/// previous slot - at most the time of one end-of-event flush - and then
+/// drains it. Workers are never stopped and never take a lock.
+///
+/// The object is created and deleted in main(); its commands are not
+/// broadcast to the workers. When monitoring is off, the hooks reduce to
+/// one relaxed atomic load.
+
+class RunMonitor
+{
+  public:
+    RunMonitor();
+    ~RunMonitor();
+
+    static RunMonitor* Instance() { return fgInstance; }
+
+    G4bool IsEnabled() const
+      { return fEnabled.load(std::memory_order_relaxed); }
+
+    // Master hooks
+    void BeginOfRun(G4int runID, G4int nofEvents);
+
+    // Worker hooks, called only when IsEnabled()
+    void AddPhoton(G4double time, G4double wavelength);
+    void UpdateStackDepth(G4int depth);
+    void EndOfEvent();
+
+    static constexpr G4int kCounterBins = 50;
+    static constexpr G4int kTimeBins = 100;
+    static constexpr G4int kWavelengthBins = 100;
+
+  private:
+    // Per-thread accumulated values
+    struct Slot
+    {
+      G4long events = 0;
+      G4long photons = 0;
+      G4int peakStackDepth = 0;
+      std::array<G4long, kCounterBins> counter = {};
+      std::array<G4long, kTimeBins> time = {};
+      std::array<G4long, kWavelengthBins> wavelength = {};
+
+      void Add(const Slot& other);
+    };
+
+    struct ThreadData
+    {
+      G4int threadID = 0;
+      std::atomic<G4int> active{0};   // slot filled by the thread
+      std::atomic<G4int> writing{-1}; // slot being filled, or -1
+      std::array<Slot, 2> slots;
+      Slot event;                     // staging for the current event
+      Slot total;                     // drained values, monitor side
+      G4int recentStackDepth = 0;     // peak since the previous snapshot
+    };
+
+    ThreadData* GetThreadData();
+    void Start();
+    void Stop();
+    void Loop(int listenSocket);
+    void Serve(int client) const;
+    void Drain();
+    void TakeSnapshot();
+    std::string MakeJson() const;
+    void DefineCommands();
+
+    static RunMonitor* fgInstance;
+    static G4ThreadLocal ThreadData* fgThreadData;
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4int fPort = 8080;
+    G4String fSocketPath;
+    G4double fInterval;  // between two snapshots
+
+    std::atomic<G4bool> fEnabled{false};
+    std::atomic<G4bool> fStop{false};
+    std::thread fThread;
+
+    mutable std::mutex fThreadsMutex;  // guards fThreads (registration)
+    std::vector<std::unique_ptr<ThreadData>> fThreads;
+
+    // Monitor side state, guarded by fSnapshotMutex
+    using Clock = std::chrono::steady_clock;
+    mutable std::mutex fSnapshotMutex;
+    G4int fRunID = -1;
+    G4int fNofEventsToProcess = 0;
+    Clock::time_point fRunStart = Clock::now();
+    Clock::time_point fLastTime = Clock::now();
+    G4long fLastEvents = 0;
+    G4long fLastPhotons = 0;
+    G4double fEventRate = 0.;
+    G4double fPhotonRate = 0.;
+    std::string fJson = "{}";
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
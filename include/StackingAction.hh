@@ -0,0 +1,69 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file StackingAction.hh
+/// \brief Definition of the B4c::StackingAction class
+
+#ifndef B4cStackingAction_h
+#define B4cStackingAction_h 1
+
+#include "G4UserStackingAction.hh"
+#include "globals.hh"
+
+namespace B4c
+{
+
+/// Stacking action class
+///
+/// In ClassifyNewTrack(), every new optical photon is accounted in the
+/// PhotonCounters by creator process and creation volume, and killed if
+/// its source is disabled in that volume (PhotonSources) or if it cannot
+/// arrive within the TimeGate. Other tracks created in the KillZone are
+/// killed. The urgent
+/// stack depth is reported to the RunMonitor when it is running. All
+/// tracks are kept urgent.
+///
+/// With /B4/lazy/enable, NewStage() materialises the next batch of
+/// photons from the LazyPhotons emission records each time the urgent
+/// stack is empty, and PrepareNewEvent() drops the records left over by
+/// an aborted event.
+
+class StackingAction : public G4UserStackingAction
+{
+  public:
+    StackingAction() = default;
+    ~StackingAction() override = default;
+
+    G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track) override;
+    void NewStage() override;
+    void PrepareNewEvent() override;
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
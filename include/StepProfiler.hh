@@ -0,0 +1,124 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file StepProfiler.hh
+/// \brief Definition of the B4c::StepProfiler class
+
+#ifndef B4cStepProfiler_h
+#define B4cStepProfiler_h 1
+
+#include "globals.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+class G4GenericMessenger;
+class G4LogicalVolume;
+class G4ParticleDefinition;
+class G4Step;
+class G4VProcess;
+
+namespace B4c
+{
+
+/// Opt-in step timing profiler
+///
+/// One instance per thread, accessed via Instance(). When enabled with
+/// /B4/profile/enable, Step() is called by the stepping action and the time
+/// elapsed since the previous step of the thread is accounted, together
+/// with a step count, to the (logical volume, process defining the step,
+/// particle) of the current step.
+///
+/// Time is read from the time stamp counter where available and converted
+/// to seconds with a per-run calibration against std::chrono::steady_clock.
+/// The entries live in a thread-local open-addressing table keyed on the
+/// object pointers, so that the hot path takes no lock. At the end of run
+/// each worker adds its table, keyed by names, to a shared report under a
+/// mutex, and the master prints it sorted by time.
+
+class StepProfiler
+{
+  public:
+    static StepProfiler* Instance();
+    ~StepProfiler();
+
+    G4bool IsEnabled() const { return fEnabled; }
+
+    void BeginOfRun();
+    void BeginOfEvent() { fLastTicks = ReadTicks(); }
+    void Step(const G4Step* step);
+    void EndOfRun(G4bool isMaster);
+
+    static std::uint64_t ReadTicks()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+      return __rdtsc();
+#else
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+  private:
+    StepProfiler();
+
+    struct Entry {
+      const G4LogicalVolume* volume = nullptr;
+      const G4VProcess* process = nullptr;
+      const G4ParticleDefinition* particle = nullptr;
+      std::uint64_t steps = 0;
+      std::uint64_t ticks = 0;
+    };
+
+    Entry& Find(const G4LogicalVolume* volume, const G4VProcess* process,
+                const G4ParticleDefinition* particle);
+    void Grow();
+    void PrintReport() const;
+
+    static G4ThreadLocal StepProfiler* fgInstance;
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4bool fEnabled = false;
+    G4int fNofLines = 30;
+
+    std::vector<Entry> fTable;   // capacity is a power of two
+    std::size_t fNofEntries = 0;
+    std::uint64_t fLastTicks = 0;
+
+    std::uint64_t fRunStartTicks = 0;
+    std::chrono::steady_clock::time_point fRunStartTime;
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,89 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file TimeGate.hh
+/// \brief Definition of the B4c::TimeGate class
+
+#ifndef B4cTimeGate_h
+#define B4cTimeGate_h 1
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+class G4GenericMessenger;
+class G4Track;
+
+namespace B4c
+{
+
+/// Acquisition time gate for the optical photons
+///
+/// With /B4/gate/enable, an optical photon is culled as soon as it can no
+/// longer reach the PMT within /B4/gate/window (default 200 ns) of the
+/// trigger, i.e. of the primary vertex time: when its global time exceeds
+/// the window or, with /B4/gate/bound (default true), when even a straight
+/// line at the speed of light to a sphere enclosing AbsoLV would arrive
+/// too late. The bound never culls a photon which could still be recorded.
+///
+/// The test is applied to new photons by the StackingAction and after each
+/// step by the stepping action; the culled photons are counted by the
+/// PhotonCounters (kCulled).
+///
+/// One instance per thread, accessed via Instance(), so that the commands
+/// exist on the master as well as on the workers.
+
+class TimeGate
+{
+  public:
+    static TimeGate* Instance();
+    ~TimeGate();
+
+    G4bool IsEnabled() const { return fEnabled; }
+    G4bool IsOutside(const G4Track* track);
+
+  private:
+    TimeGate();
+
+    void FindTarget();
+
+    static G4ThreadLocal TimeGate* fgInstance;
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4bool fEnabled = false;
+    G4double fWindow = 0.;
+    G4bool fUseBound = true;
+
+    // Sphere enclosing AbsoLV in the global frame (radius < 0 if unknown)
+    G4bool fTargetFound = false;
+    G4ThreeVector fTargetCentre;
+    G4double fTargetRadius = -1.;
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
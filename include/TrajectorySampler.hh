@@ -0,0 +1,107 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file TrajectorySampler.hh
+/// \brief Definition of the B4c::TrajectorySampler class
+
+#ifndef B4cTrajectorySampler_h
+#define B4cTrajectorySampler_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+class G4Event;
+class G4GenericMessenger;
+class G4Track;
+class G4TrackingManager;
+class G4VTrajectory;
+
+namespace B4c
+{
+
+/// Storage-time sampling of the optical photon trajectories
+///
+/// When trajectories are stored (e.g. by /vis/scene/add/trajectories),
+/// /B4/trajectory/photons selects which optical photon trajectories are
+/// kept; those of the other particles are always kept:
+/// - all:       every photon (default),
+/// - none:      no photon,
+/// - fraction:  each photon with probability /B4/trajectory/fraction,
+/// - reservoir: a uniform sample of at most /B4/trajectory/reservoir
+///              photons per event (algorithm R); a trajectory leaving the
+///              sample is removed from the event and deleted.
+///
+/// The trajectory of a rejected photon is never created, so the memory
+/// held by an event is bounded in the reservoir mode. The random numbers
+/// are a hash of the event and track IDs: the sampling does not consume
+/// the Geant4 engine and the physics is the same with or without it.
+///
+/// One instance per thread, accessed via Instance(), so that the commands
+/// exist on the master as well as on the workers.
+
+class TrajectorySampler
+{
+  public:
+    static TrajectorySampler* Instance();
+    ~TrajectorySampler();
+
+    void BeginOfEvent(const G4Event* event);
+    void PreTrack(const G4Track* track, G4TrackingManager* manager);
+    void PostTrack(G4TrackingManager* manager);
+
+  private:
+    enum Mode { kAll, kNone, kFraction, kReservoir };
+
+    TrajectorySampler();
+
+    G4double Uniform(G4int trackID) const;
+    void Evict(G4VTrajectory* trajectory);
+
+    static G4ThreadLocal TrajectorySampler* fgInstance;
+
+    G4GenericMessenger* fMessenger = nullptr;
+    G4String fModeName = "all";
+    G4double fFraction = 0.01;
+    G4int fReservoirSize = 1000;
+
+    // Per event
+    Mode fMode = kAll;
+    G4int fEventID = 0;
+    G4int fNofPhotons = 0;
+    std::vector<G4VTrajectory*> fReservoir;
+
+    // Per track
+    G4int fSavedStoreMode = 0;
+    G4bool fRestore = false;
+    G4int fSlot = -1;
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
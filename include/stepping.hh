@@ -6,7 +6,17 @@
 
 #include "CalorimeterSD.hh"
 #include "EventAction.hh"
+#include "LazyPhotons.hh"
+#include "StepProfiler.hh"
 
+// Stepping action: accounts the fate of optical photons (absorbed in a
+// volume or at a wall, escaped from the world) in the
+// B4c::PhotonCounters, sums their path lengths per material in a
+// B4c::PhotonTrackInfo and, when /B4/profile/enable is set, times every
+// step with the B4c::StepProfiler.
+// With /B4/lazy/enable, the steps of the other particles are recorded as
+// compact photon emission records in the B4c::LazyPhotons. Photons which
+// can no longer arrive within the B4c::TimeGate are killed.
 class MySteppingAction : public G4UserSteppingAction
 {
 public:
@@ -17,7 +27,9 @@ public:
 
 private:
     //EventAction *fEventAction;
+    B4c::StepProfiler *fProfiler;
+    B4c::LazyPhotons *fLazy;
 };
 
 
-#endif
\ No newline at end of file
+#endif
@@ -31,9 +31,14 @@
 #include "PrimaryGeneratorAction.hh"
 #include "RunAction.hh"
 #include "EventAction.hh"
+#include "PMTDigitizer.hh"
+#include "StackingAction.hh"
+#include "TrackingAction.hh"
 #include "run.hh"
 #include "stepping.hh"
 
+#include "G4DigiManager.hh"
+
 using namespace B4;
 
 namespace B4c
@@ -54,6 +59,9 @@ ActionInitialization::~ActionInitialization()
 void ActionInitialization::BuildForMaster() const
 {
   SetUserAction(new RunAction);
+
+  // The master copy only holds the /B4/digi/ commands
+  G4DigiManager::GetDMpointer()->AddNewModule(new PMTDigitizer("PMTDigitizer"));
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -63,10 +71,13 @@ void ActionInitialization::Build() const
   SetUserAction(new PrimaryGeneratorAction);
   SetUserAction(new RunAction);
   SetUserAction(new EventAction);
+  SetUserAction(new StackingAction);
+  SetUserAction(new TrackingAction);
+  SetUserAction(new MySteppingAction);
+
+  G4DigiManager::GetDMpointer()->AddNewModule(new PMTDigitizer("PMTDigitizer"));
 
-  /*MySteppingAction *steppingAction = new MySteppingAction();
-  SetUserAction(steppingAction);
-  MyRunAction *raction = new MyRunAction();
+  /*MyRunAction *raction = new MyRunAction();
   SetUserAction(raction);*/
 }
 
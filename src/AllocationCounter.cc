@@ -0,0 +1,113 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file AllocationCounter.cc
+/// \brief Implementation of the B4c::AllocationCounter functions
+
+#include "AllocationCounter.hh"
+
+#ifdef B4_COUNT_ALLOCATIONS
+#include <cstdlib>
+#include <new>
+
+namespace {
+  // Plain thread_local integer: no constructor, safe to use in operator new
+  thread_local std::uint64_t tAllocations = 0;
+
+  void* Allocate(std::size_t size)
+  {
+    ++tAllocations;
+    if ( size == 0 ) size = 1;
+    return std::malloc(size);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void* operator new(std::size_t size)
+{
+  auto pointer = Allocate(size);
+  if ( ! pointer ) throw std::bad_alloc();
+  return pointer;
+}
+
+void* operator new[](std::size_t size)
+{
+  auto pointer = Allocate(size);
+  if ( ! pointer ) throw std::bad_alloc();
+  return pointer;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  return Allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+  return Allocate(size);
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept
+{
+  std::free(pointer);
+}
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+  std::free(pointer);
+}
+#endif
+
+namespace B4c
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool AllocationCounter::IsEnabled()
+{
+#ifdef B4_COUNT_ALLOCATIONS
+  return true;
+#else
+  return false;
+#endif
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::uint64_t AllocationCounter::GetCount()
+{
+#ifdef B4_COUNT_ALLOCATIONS
+  return tAllocations;
+#else
+  return 0;
+#endif
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
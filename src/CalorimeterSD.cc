@@ -28,6 +28,13 @@
 /// \brief Implementation of the B4c::CalorimeterSD class
 
 #include "CalorimeterSD.hh"
+#include "Checkpoint.hh"
+#include "PerfCounters.hh"
+#include "Photocathode.hh"
+#include "PhotonCounters.hh"
+#include "PhotonSources.hh"
+#include "PhotonTrackInfo.hh"
+#include "RunMonitor.hh"
 #include "G4HCofThisEvent.hh"
 #include "G4Step.hh"
 #include "G4ThreeVector.hh"
@@ -49,6 +56,9 @@ CalorimeterSD::CalorimeterSD(const G4String& name,
    fNofCells(nofCells)
 {
   collectionName.insert(hitsCollectionName);
+
+  // fNofCells for cells + one more for total sums
+  fCalorHits.Reserve(fNofCells+1);
 }
 
 
@@ -58,22 +68,24 @@ CalorimeterSD::~CalorimeterSD()
 
 
 
-void CalorimeterSD::Initialize(G4HCofThisEvent* hce)
+void CalorimeterSD::SetPhotocathode(const Photocathode* photocathode)
 {
-  // Create hits collection
-  fHitsCollection
-    = new CalorHitsCollection(SensitiveDetectorName, collectionName[0]);
+  fPhotocathode = photocathode;
+}
+
 
-  // Add this collection in hce
-  auto hcID
-    = G4SDManager::GetSDMpointer()->GetCollectionID(collectionName[0]);
-  hce->AddHitsCollection( hcID, fHitsCollection );
 
-  // Create hits
+void CalorimeterSD::Initialize(G4HCofThisEvent* /*hce*/)
+{
+  // Reset the hits kept from the previous event
   // fNofCells for cells + one more for total sums
+  fCalorHits.Reset();
   for (G4int i=0; i<fNofCells+1; i++ ) {
-    fHitsCollection->insert(new CalorHit());
+    fCalorHits.Add();
   }
+
+  // Forget the detected photons, keeping their storage
+  fPhotonHits.Reset();
 }
 
 
@@ -81,8 +93,10 @@ void CalorimeterSD::Initialize(G4HCofThisEvent* hce)
 G4bool CalorimeterSD::ProcessHits(G4Step* step,
                                      G4TouchableHistory*)
 {
+  PerfCounters::Scope perfScope(PerfCounters::kProcessHits);
   auto analysisManager = G4AnalysisManager::Instance();
-  G4int evt = G4RunManager::GetRunManager()->GetCurrentEvent()->GetEventID();
+  G4int evt = G4RunManager::GetRunManager()->GetCurrentEvent()->GetEventID()
+            + Checkpoint::GetEventOffset();
   G4int pdg = step->GetTrack()->GetParticleDefinition()->GetPDGEncoding();
   auto particlePDG = step->GetTrack()->GetDefinition()->GetPDGEncoding();
   // energy deposit
@@ -102,17 +116,17 @@ G4bool CalorimeterSD::ProcessHits(G4Step* step,
   auto layerNumber = touchable->GetReplicaNumber(1);
 
   // Get hit accounting data for this cell
-  auto hit = (*fHitsCollection)[layerNumber];
-  if ( ! hit ) {
+  if ( layerNumber < 0 || layerNumber >= G4int(fCalorHits.GetSize()) - 1 ) {
     G4ExceptionDescription msg;
     msg << "Cannot access hit " << layerNumber;
     G4Exception("CalorimeterSD::ProcessHits()",
       "MyCode0004", FatalException, msg);
   }
 
+  auto hit = &fCalorHits[layerNumber];
+
   // Get hit for total accounting
-  auto hitTotal
-    = (*fHitsCollection)[fHitsCollection->entries()-1];
+  auto hitTotal = &fCalorHits[fCalorHits.GetSize()-1];
 
   // Add values
   double energy = step->GetTrack()->GetKineticEnergy();
@@ -122,17 +136,47 @@ G4bool CalorimeterSD::ProcessHits(G4Step* step,
   time = step->GetPreStepPoint()->GetGlobalTime();
   if (pdg == -22){
     if (wavelength >= 300){
+      if ( fPhotocathode ) {
+        auto counters = PhotonCounters::Instance();
+        counters->Add(PhotonCounters::kReachedPMT);
+        auto stage = fPhotocathode->Sample(energy);
+        if ( stage >= Photocathode::kFailedCE ) {
+          counters->Add(PhotonCounters::kPassedQE);
+        }
+        if ( stage != Photocathode::kDetected ) {
+          step->GetTrack()->SetTrackStatus(fStopAndKill);
+          return true;
+        }
+        counters->Add(PhotonCounters::kDetected);
+      }
       event_counter++;
       
       analysisManager->FillNtupleDColumn(0,0,evt);
       analysisManager->FillNtupleDColumn(0,1,wavelength);
       //analysisManager->FillNtupleDColumn(2,energy);
       analysisManager->FillNtupleDColumn(0,2,time);
+      auto info = dynamic_cast<const PhotonTrackInfo*>(
+        step->GetTrack()->GetUserInformation());
+      auto pathLengths = info ? info->GetPathLengths()
+                              : PhotonTrackInfo::PathLengths{};
+      for ( G4int i = 0; i < PhotonTrackInfo::kNofPaths; ++i ) {
+        analysisManager->FillNtupleDColumn(0, 3+i, pathLengths[i]);
+      }
+      auto creator = PhotonSources::GetCreator(step->GetTrack());
+      analysisManager->FillNtupleIColumn(0, 3+PhotonTrackInfo::kNofPaths,
+                                         creator);
       analysisManager->AddNtupleRow(0);
+      fPhotonHits.Add(PhotonHit(time, wavelength, pathLengths, creator));
+      PhotonCounters::Instance()->Add(PhotonCounters::kRecorded);
+      auto monitor = RunMonitor::Instance();
+      if ( monitor && monitor->IsEnabled() ) {
+        monitor->AddPhoton(time, wavelength);
+      }
       //G4cout << "Energy: " << energy << G4endl;
       //G4cout << "Wavelength: " << wavelength << G4endl;
     }
     else{
+      PhotonCounters::Instance()->Add(PhotonCounters::kBelowCutoff);
       step->GetTrack()->SetTrackStatus(fStopAndKill);
     }
   }
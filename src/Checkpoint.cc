@@ -0,0 +1,277 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file Checkpoint.cc
+/// \brief Implementation of the B4c::Checkpoint class
+
+#include "Checkpoint.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4Run.hh"
+#include "G4RunManager.hh"
+#include "G4UImanager.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace B4c
+{
+
+G4int Checkpoint::fgEventOffset = 0;
+
+namespace {
+  const char* kMagic = "B4Checkpoint";
+  // 2: one "name value" line per photon counter
+  const G4int kVersion = 2;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+Checkpoint::Checkpoint()
+{
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+Checkpoint::~Checkpoint()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Checkpoint::BeamOn(G4int nofEvents)
+{
+  fRequested = nofEvents;
+  fCompletedSegments = 0;
+  fCompletedEvents = 0;
+  fCounters.fill(0);
+
+  if ( ! fResumeFile.empty() ) {
+    auto resumeFile = fResumeFile;
+    fResumeFile = "";  // only the first checkpointed run is resumed
+    if ( ! Load(resumeFile, nofEvents) ) return;
+    G4cout
+      << "--> Resuming from " << resumeFile << " after segment "
+      << fCompletedSegments - 1 << " (" << fCompletedEvents << " of "
+      << fRequested << " events done)" << G4endl;
+  }
+
+  auto runManager = G4RunManager::GetRunManager();
+  auto counters = PhotonCounters::Instance();
+  while ( fCompletedEvents < fRequested ) {
+    auto segmentEvents = std::min(fSegmentSize, fRequested - fCompletedEvents);
+
+    std::ostringstream outputName;
+    outputName << fOutputName << "_s"
+               << std::setw(4) << std::setfill('0') << fCompletedSegments;
+    G4UImanager::GetUIpointer()->ApplyCommand(
+      "/B4/output/fileName " + outputName.str());
+
+    fgEventOffset = fCompletedEvents;
+    runManager->BeamOn(segmentEvents);
+
+    // Do not checkpoint an aborted segment, it is redone on resume
+    auto run = runManager->GetCurrentRun();
+    if ( ! run || run->GetNumberOfEvent() != segmentEvents ) {
+      G4cout << "--> Segment " << fCompletedSegments << " incomplete, "
+             << "checkpointed run stopped" << G4endl;
+      break;
+    }
+
+    for ( G4int i = 0; i < PhotonCounters::kNofCounters; ++i ) {
+      fCounters[i] += counters->GetRunValue(PhotonCounters::Counter(i));
+    }
+    ++fCompletedSegments;
+    fCompletedEvents += segmentEvents;
+    Save();
+  }
+  fgEventOffset = 0;
+
+  if ( fCompletedEvents == fRequested ) {
+    G4cout
+      << G4endl << "--> Checkpointed run complete: " << fCompletedEvents
+      << " events in " << fCompletedSegments << " segments "
+      << fOutputName << "_s*" << G4endl;
+    PhotonCounters::Print(fCounters);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool Checkpoint::Load(const G4String& fileName, G4int nofEvents)
+{
+  std::ifstream input(fileName);
+  G4String magic, key;
+  G4int version = 0;
+  input >> magic >> version;
+  if ( input.good() && magic == kMagic && version != kVersion ) {
+    G4ExceptionDescription msg;
+    msg << "Checkpoint file " << fileName << " has format version "
+        << version << ", this build reads version " << kVersion;
+    G4Exception("Checkpoint::Load()",
+      "MyCode0007", FatalException, msg);
+    return false;
+  }
+
+  G4bool ok = input.good() && magic == kMagic;
+  ok = ok && ( input >> key >> fRequested ) && key == "requested";
+  ok = ok && ( input >> key >> fSegmentSize ) && key == "segmentSize";
+  ok = ok && ( input >> key >> fOutputName ) && key == "output";
+  ok = ok && ( input >> key >> fCompletedSegments ) && key == "segments";
+  ok = ok && ( input >> key >> fCompletedEvents ) && key == "events";
+  // The counters must be those of this build, in the same order
+  G4int nofCounters = 0;
+  ok = ok && ( input >> key >> nofCounters ) && key == "counters";
+  G4String mismatch;
+  for ( G4int i = 0; ok && i < nofCounters; ++i ) {
+    G4long value = 0;
+    ok = ok && ( input >> key >> value );
+    if ( ! ok || ! mismatch.empty() ) continue;
+    if ( i >= PhotonCounters::kNofCounters ) {
+      mismatch = key + " (counter " + std::to_string(i) + " of "
+               + std::to_string(nofCounters) + ")";
+    }
+    else if ( key != PhotonCounters::GetName(PhotonCounters::Counter(i)) ) {
+      mismatch = key + " instead of "
+               + PhotonCounters::GetName(PhotonCounters::Counter(i));
+    }
+    else {
+      fCounters[i] = value;
+    }
+  }
+  if ( ok && mismatch.empty() && nofCounters != PhotonCounters::kNofCounters ) {
+    mismatch = std::to_string(nofCounters) + " counters instead of "
+             + std::to_string(PhotonCounters::kNofCounters);
+  }
+  if ( ok && ! mismatch.empty() ) {
+    G4ExceptionDescription msg;
+    msg << "Checkpoint file " << fileName << " holds the photon counters "
+        << "of another build: " << mismatch;
+    G4Exception("Checkpoint::Load()",
+      "MyCode0007", FatalException, msg);
+    return false;
+  }
+  ok = ok && ( input >> key ) && key == "engine";
+  if ( ok ) {
+    G4Random::restoreFullState(input);
+    ok = ! input.fail();
+  }
+
+  if ( ! ok ) {
+    G4ExceptionDescription msg;
+    msg << "Cannot read checkpoint file " << fileName;
+    G4Exception("Checkpoint::Load()",
+      "MyCode0007", FatalException, msg);
+    return false;
+  }
+  if ( fRequested != nofEvents ) {
+    G4ExceptionDescription msg;
+    msg << "Checkpoint file " << fileName << " was written for "
+        << fRequested << " events, not " << nofEvents;
+    G4Exception("Checkpoint::Load()",
+      "MyCode0007", FatalException, msg);
+    return false;
+  }
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Checkpoint::Save() const
+{
+  // Write to a temporary file and rename it, so that an interruption
+  // never leaves a truncated checkpoint behind
+  auto tmpName = fFileName + ".tmp";
+  {
+    std::ofstream output(tmpName);
+    output
+      << kMagic << " " << kVersion << "\n"
+      << "requested " << fRequested << "\n"
+      << "segmentSize " << fSegmentSize << "\n"
+      << "output " << fOutputName << "\n"
+      << "segments " << fCompletedSegments << "\n"
+      << "events " << fCompletedEvents << "\n"
+      << "counters " << PhotonCounters::kNofCounters << "\n";
+    for ( G4int i = 0; i < PhotonCounters::kNofCounters; ++i ) {
+      output << PhotonCounters::GetName(PhotonCounters::Counter(i)) << " "
+             << fCounters[i] << "\n";
+    }
+    output << "engine\n";
+    G4Random::saveFullState(output);
+    output << "\n";
+    if ( ! output.good() ) {
+      G4ExceptionDescription msg;
+      msg << "Cannot write checkpoint file " << tmpName;
+      G4Exception("Checkpoint::Save()",
+        "MyCode0007", JustWarning, msg);
+      return;
+    }
+  }
+  std::rename(tmpName.c_str(), fFileName.c_str());
+
+  G4cout << "--> Checkpoint " << fFileName << ": " << fCompletedEvents
+         << " of " << fRequested << " events" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Checkpoint::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/B4/checkpoint/",
+                                      "Checkpointed batch runs");
+
+  auto& beamOnCmd = fMessenger->DeclareMethod("beamOn", &Checkpoint::BeamOn,
+    "Process events in checkpointed segments (resumes with exampleB4c -r).");
+  beamOnCmd.SetParameterName("nofEvents", false);
+  beamOnCmd.SetRange("nofEvents>0");
+  beamOnCmd.AvailableForStates(G4State_Idle);
+  beamOnCmd.command->SetToBeBroadcasted(false);
+
+  auto& segmentCmd = fMessenger->DeclareProperty("segment", fSegmentSize,
+    "Number of events between two checkpoints.");
+  segmentCmd.SetParameterName("nofEvents", false);
+  segmentCmd.SetRange("nofEvents>0");
+  segmentCmd.command->SetToBeBroadcasted(false);
+
+  auto& fileCmd = fMessenger->DeclareProperty("file", fFileName,
+    "Name of the checkpoint file.");
+  fileCmd.command->SetToBeBroadcasted(false);
+
+  auto& outputCmd = fMessenger->DeclareProperty("output", fOutputName,
+    "Base name of the per-segment output files.");
+  outputCmd.command->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
@@ -0,0 +1,114 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file CompactOutput.cc
+/// \brief Implementation of the B4c::CompactOutput class
+
+#include "CompactOutput.hh"
+
+namespace B4c
+{
+
+namespace {
+  const std::size_t kBlockSize = 1 << 20;
+}
+
+G4ThreadLocal CompactOutput* CompactOutput::fgInstance = nullptr;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CompactOutput* CompactOutput::Instance()
+{
+  if ( ! fgInstance ) {
+    fgInstance = new CompactOutput();
+  }
+  return fgInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CompactOutput::~CompactOutput()
+{
+  Close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool CompactOutput::Open(const G4String& fileName)
+{
+  Close();
+  fFile.open(fileName, std::ios::binary | std::ios::trunc);
+  if ( ! fFile ) {
+    G4ExceptionDescription msg;
+    msg << "Cannot open " << fileName << ", no compact photon output.";
+    G4Exception("CompactOutput::Open()", "MyCode0011", JustWarning, msg);
+    return false;
+  }
+  fBuffer = PhotonCodec::GetMagic();
+  fPhotons.clear();
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CompactOutput::Close()
+{
+  if ( ! fFile.is_open() ) return;
+  Flush();
+  fFile.close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CompactOutput::AddHits(const PhotonHits& hits)
+{
+  for ( const auto& hit : hits ) {
+    fPhotons.push_back({hit.GetWavelength(), hit.GetTime(),
+                        G4int(hit.GetCreator())});
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CompactOutput::WriteEvent(G4int eventID, G4double t0)
+{
+  for ( auto& photon : fPhotons ) photon.time -= t0;
+  PhotonCodec::EncodeEvent(eventID, fPhotons, fBuffer);
+  fPhotons.clear();
+  if ( fBuffer.size() >= kBlockSize ) Flush();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CompactOutput::Flush()
+{
+  fFile.write(fBuffer.data(), fBuffer.size());
+  fBuffer.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
@@ -28,30 +28,261 @@
 /// \brief Implementation of the B4c::DetectorConstruction class
 
 #include "DetectorConstruction.hh"
+#include "DetectorRegion.hh"
+#include "KillZoneSD.hh"
+#include "Photocathode.hh"
 #include "G4Material.hh"
 #include "G4MaterialTable.hh"
+#include "G4GenericMessenger.hh"
+#include "G4LogicalBorderSurface.hh"
+#include "G4LogicalSkinSurface.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4Version.hh"
+
+#ifdef B4_WITH_GDML
+#include "G4GDMLParser.hh"
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#ifndef B4_GEOMETRY_SOURCE_HASH
+#define B4_GEOMETRY_SOURCE_HASH "unknown"
+#endif
 
 namespace B4c
 {
 
+namespace
+{
+  // Not stored in GDML, applied to the Scint material after reading
+  const G4double kScintBirksConstant = 0.126*mm/MeV;
+
+  // FNV-1a, printed as 16 hex digits
+  G4String Hash(const std::string& text)
+  {
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    for ( auto c : text ) {
+      hash ^= std::uint8_t(c);
+      hash *= 0x100000001b3ull;
+    }
+    char digits[17];
+    std::snprintf(digits, sizeof(digits), "%016llx", (unsigned long long)hash);
+    return digits;
+  }
+
+  G4String HashFile(const G4String& fileName)
+  {
+    std::ifstream file(fileName, std::ios::binary);
+    return Hash(std::string(std::istreambuf_iterator<char>(file),
+                            std::istreambuf_iterator<char>()));
+  }
+}
+
 //G4ThreadLocal
 
 
 DetectorConstruction::DetectorConstruction()
 {
     nist = G4NistManager::Instance();
+    fPhotocathode = new Photocathode();
+    fQDRegion = new DetectorRegion("QD");
+    fBottleRegion = new DetectorRegion("Bottle");
+    fSurroundingsRegion = new DetectorRegion("Surroundings");
+    DefineCommands();
 }
 
 
 DetectorConstruction::~DetectorConstruction()
-{}
+{
+  delete fPhotocathode;
+  delete fQDRegion;
+  delete fBottleRegion;
+  delete fSurroundingsRegion;
+  delete fMessenger;
+  delete fGeometryMessenger;
+}
+
+
+void DetectorConstruction::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/B4/surface/",
+                                      "Black box optical surfaces");
+
+  auto& wallCmd = fMessenger->DeclareMethod("wallReflectivity",
+    &DetectorConstruction::SetWallReflectivity,
+    "Reflectivity of the black box inner walls (0 = absorbing).");
+  wallCmd.SetParameterName("reflectivity", false);
+  wallCmd.SetRange("reflectivity>=0. && reflectivity<=1.");
+  wallCmd.AvailableForStates(G4State_PreInit, G4State_Idle);
+  wallCmd.command->SetToBeBroadcasted(false);
+
+  auto& standCmd = fMessenger->DeclareMethod("standReflectivity",
+    &DetectorConstruction::SetStandReflectivity,
+    "Reflectivity of the aluminium stand (0 = absorbing).");
+  standCmd.SetParameterName("reflectivity", false);
+  standCmd.SetRange("reflectivity>=0. && reflectivity<=1.");
+  standCmd.AvailableForStates(G4State_PreInit, G4State_Idle);
+  standCmd.command->SetToBeBroadcasted(false);
+
+  fGeometryMessenger = new G4GenericMessenger(this, "/B4/geometry/",
+                                              "Geometry import and export");
+
+  auto& cacheCmd = fGeometryMessenger->DeclareProperty("cache", fGDMLCache,
+    "Read the geometry from this GDML file when up to date, else build "
+    "and write it.");
+  cacheCmd.SetParameterName("fileName", false);
+  cacheCmd.AvailableForStates(G4State_PreInit);
+  cacheCmd.command->SetToBeBroadcasted(false);
+
+  auto& exportCmd = fGeometryMessenger->DeclareMethod("exportGDML",
+    &DetectorConstruction::WriteGDML,
+    "Write the geometry with its optical properties to a GDML file.");
+  exportCmd.SetParameterName("fileName", false);
+  exportCmd.AvailableForStates(G4State_Idle);
+  exportCmd.command->SetToBeBroadcasted(false);
+}
+
+
+G4String DetectorConstruction::GetConfigHash()
+{
+  std::ostringstream config;
+  config << "source " << B4_GEOMETRY_SOURCE_HASH
+         << " geant4 " << G4VERSION_NUMBER;
+  return Hash(config.str());
+}
+
+
+G4VPhysicalVolume* DetectorConstruction::ReadGDMLCache()
+{
+#ifdef B4_WITH_GDML
+  std::ifstream sidecar(fGDMLCache + ".hash");
+  std::string configKey, configHash, gdmlKey, gdmlHash;
+  sidecar >> configKey >> configHash >> gdmlKey >> gdmlHash;
+  if ( ! sidecar || configHash != GetConfigHash()
+       || gdmlHash != HashFile(fGDMLCache) ) {
+    G4cout << "--> Geometry cache " << fGDMLCache
+           << " missing or stale, building the geometry" << G4endl;
+    return nullptr;
+  }
+
+  G4cout << "--> Reading the geometry from " << fGDMLCache << G4endl;
+  G4GDMLParser parser;
+  parser.Read(fGDMLCache, false);  // no schema validation
+  auto world = parser.GetWorldVolume();
+
+  if ( auto scint = G4Material::GetMaterial("Scint", false) ) {
+    scint->GetIonisation()->SetBirksConstant(kScintBirksConstant);
+  }
+  FindSurfaces(world);
+  return world;
+#else
+  G4cout << "--> /B4/geometry/cache ignored: Geant4 built without GDML"
+         << G4endl;
+  return nullptr;
+#endif
+}
+
+
+void DetectorConstruction::WriteGDML(const G4String& fileName)
+{
+#ifdef B4_WITH_GDML
+  if ( ! fWorld ) return;
+
+  // The parser does not overwrite an existing file
+  std::remove(fileName.c_str());
+  G4GDMLParser parser;
+  parser.Write(fileName, fWorld, false);  // names without pointer suffix
+
+  std::ofstream sidecar(fileName + ".hash");
+  sidecar << "config " << GetConfigHash() << "\n"
+          << "gdml " << HashFile(fileName) << "\n";
+#else
+  G4cout << "--> Cannot write " << fileName
+         << ": Geant4 built without GDML" << G4endl;
+#endif
+}
+
+
+void DetectorConstruction::FindSurfaces(const G4VPhysicalVolume* world)
+{
+  auto physBox = G4PhysicalVolumeStore::GetInstance()->GetVolume(
+    "physBox", false);
+  auto logicStand = G4LogicalVolumeStore::GetInstance()->GetVolume(
+    "Stand", false);
+
+  auto border = G4LogicalBorderSurface::GetSurface(physBox, world);
+  fWallSurface = border
+    ? dynamic_cast<G4OpticalSurface*>(border->GetSurfaceProperty()) : nullptr;
+  auto skin = G4LogicalSkinSurface::GetSurface(logicStand);
+  fStandSurface = skin
+    ? dynamic_cast<G4OpticalSurface*>(skin->GetSurfaceProperty()) : nullptr;
+
+  SetReflectivity(fWallSurface, fWallReflectivity);
+  SetReflectivity(fStandSurface, fStandReflectivity);
+}
+
+
+void DetectorConstruction::SetWallReflectivity(G4double reflectivity)
+{
+  fWallReflectivity = reflectivity;
+  SetReflectivity(fWallSurface, reflectivity);
+}
+
+
+void DetectorConstruction::SetStandReflectivity(G4double reflectivity)
+{
+  fStandReflectivity = reflectivity;
+  SetReflectivity(fStandSurface, reflectivity);
+}
+
+
+void DetectorConstruction::SetReflectivity(G4OpticalSurface* surface,
+                                           G4double reflectivity)
+{
+  // Before /run/initialize the value is applied in DefineVolumes()
+  if ( ! surface ) return;
+
+  auto mpt = surface->GetMaterialPropertiesTable();
+  if ( ! mpt ) {
+    mpt = new G4MaterialPropertiesTable();
+    surface->SetMaterialPropertiesTable(mpt);
+  }
+  if ( mpt->GetProperty("REFLECTIVITY") ) {
+    mpt->RemoveProperty("REFLECTIVITY");
+  }
+  std::vector<G4double> energies = { 1.*eV, 7.*eV };
+  std::vector<G4double> values = { reflectivity, reflectivity };
+  mpt->AddProperty("REFLECTIVITY", energies, values);
+}
 
 
 G4VPhysicalVolume* DetectorConstruction::Construct()
 {
-  DefineMaterials();
+  fWorld = nullptr;
+  if ( fGDMLCache.size() ) fWorld = ReadGDMLCache();
+
+  if ( ! fWorld ) {
+    DefineMaterials();
+    fWorld = DefineVolumes();
+    if ( fGDMLCache.size() ) WriteGDML(fGDMLCache);
+  }
 
-  return DefineVolumes();
+  DefineRegions();
+  return fWorld;
+}
+
+
+void DetectorConstruction::DefineRegions()
+{
+  // Innermost first: a region root stops the descent of the outer ones
+  fQDRegion->Attach({"QD"});
+  fBottleRegion->Attach({"Bottle"});
+  fSurroundingsRegion->Attach({"logicBox"});
 }
 
 
@@ -144,7 +375,7 @@ void DetectorConstruction::DefineMaterials()
         Scint->SetMaterialPropertiesTable(mptScint);
     
         // Set the Birks Constant for the scintillator (assumption)
-        Scint->GetIonisation()->SetBirksConstant(0.126*mm/MeV);
+        Scint->GetIonisation()->SetBirksConstant(kScintBirksConstant);
     
 //World(Air)
         G4MaterialPropertiesTable *mptWorld = new G4MaterialPropertiesTable();       //Air (worldMat) properties table
@@ -186,7 +417,7 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
 
         G4Box *solidBox = new G4Box("solidBox", 0.425*m, 0.27*m, 0.28*m);
 
-        G4LogicalVolume *logicBox = new G4LogicalVolume(solidWorld, worldMat, "logicBox");
+        G4LogicalVolume *logicBox = new G4LogicalVolume(solidBox, worldMat, "logicBox");
 
         G4VPhysicalVolume *physBox = new G4PVPlacement(0, G4ThreeVector(0., 0., 0.), logicBox, "physBox", logicWorld, false, 0, true);
     
@@ -237,6 +468,19 @@ G4VPhysicalVolume* DetectorConstruction::DefineVolumes()
         rotationMatrix->rotateZ(-0.5*CLHEP::pi);
     
         new G4PVPlacement(rotationMatrix, G4ThreeVector(-0.15*m, 0.*m, -0.09*m), absorberLV, "Abso", logicBox, false, 0, true);
+
+        //-----------Optical surfaces---------------
+
+        // Black box inner walls, seen from inside and from outside
+        fWallSurface = new G4OpticalSurface("WallSurface", unified, ground, dielectric_metal);
+        new G4LogicalBorderSurface("WallInside", physBox, physWorld, fWallSurface);
+        new G4LogicalBorderSurface("WallOutside", physWorld, physBox, fWallSurface);
+        SetReflectivity(fWallSurface, fWallReflectivity);
+
+        // Aluminium stand
+        fStandSurface = new G4OpticalSurface("StandSurface", unified, ground, dielectric_metal);
+        new G4LogicalSkinSurface("StandSurface", logicStand, fStandSurface);
+        SetReflectivity(fStandSurface, fStandReflectivity);
         
 
     
@@ -347,6 +591,7 @@ void DetectorConstruction::ConstructSDandField()
   G4SDManager::GetSDMpointer()->SetVerboseLevel(1);
   G4SDManager::GetSDMpointer()->AddNewDetector(absoSD);
   SetSensitiveDetector("AbsoLV",absoSD);
+  absoSD->SetPhotocathode(fPhotocathode);
 
  //Gap is the QD
   auto gapSD
@@ -354,6 +599,11 @@ void DetectorConstruction::ConstructSDandField()
   G4SDManager::GetSDMpointer()->AddNewDetector(gapSD);
   SetSensitiveDetector("QD",gapSD);
 
+  // Kill zone: the world outside the black box
+  auto killZoneSD = new KillZoneSD("KillZoneSD");
+  G4SDManager::GetSDMpointer()->AddNewDetector(killZoneSD);
+  SetSensitiveDetector("logicWorld", killZoneSD);
+
 
     
 }
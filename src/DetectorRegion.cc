@@ -0,0 +1,192 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file DetectorRegion.cc
+/// \brief Implementation of the B4c::DetectorRegion class
+
+#include "DetectorRegion.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4ProductionCuts.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4UserLimits.hh"
+#include "G4VPhysicalVolume.hh"
+
+namespace B4c
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DetectorRegion::DetectorRegion(const G4String& name)
+  : fName(name)
+{
+  fCuts = new G4ProductionCuts();
+  fCuts->SetProductionCut(0.7*mm);
+  fLimits = new G4UserLimits();
+
+  fMessenger = new G4GenericMessenger(this, "/B4/region/" + name + "/",
+                                      "Cuts and limits of the " + name
+                                      + " region");
+
+  auto declare = [this](const G4String& command, const G4String& unit,
+                        void (DetectorRegion::*method)(G4double),
+                        const G4String& guidance) {
+    auto& cmd = fMessenger->DeclareMethodWithUnit(command, unit, method,
+                                                  guidance);
+    cmd.SetParameterName("value", false);
+    cmd.SetRange("value>=0.");
+    cmd.command->SetToBeBroadcasted(false);
+    cmd.AvailableForStates(G4State_PreInit, G4State_Idle);
+  };
+  declare("cut", "mm", &DetectorRegion::SetCut,
+          "Production cut of the gammas, electrons, positrons and protons.");
+  declare("gammaCut", "mm", &DetectorRegion::SetGammaCut,
+          "Production cut of the gammas.");
+  declare("electronCut", "mm", &DetectorRegion::SetElectronCut,
+          "Production cut of the electrons.");
+  declare("positronCut", "mm", &DetectorRegion::SetPositronCut,
+          "Production cut of the positrons.");
+  declare("maxStep", "mm", &DetectorRegion::SetMaxStep,
+          "Maximum step length of the charged particles.");
+  declare("maxTrackLength", "mm", &DetectorRegion::SetMaxTrackLength,
+          "Maximum track length of the charged particles.");
+  declare("maxTime", "ns", &DetectorRegion::SetMaxTime,
+          "Maximum global time of the charged particles.");
+  declare("minKinEnergy", "MeV", &DetectorRegion::SetMinKinEnergy,
+          "Kinetic energy below which a charged particle is killed.");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DetectorRegion::~DetectorRegion()
+{
+  delete fMessenger;
+  delete fLimits;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorRegion::Attach(const std::vector<G4String>& rootVolumes)
+{
+  if ( ! fRegion ) {
+    fRegion = G4RegionStore::GetInstance()->FindOrCreateRegion(fName);
+    fRegion->SetProductionCuts(fCuts);
+  }
+
+  auto store = G4LogicalVolumeStore::GetInstance();
+  for ( const auto& name : rootVolumes ) {
+    auto volume = store->GetVolume(name, false);
+    if ( ! volume ) {
+      G4ExceptionDescription msg;
+      msg << "Logical volume " << name << " not found, not added to the "
+          << fName << " region.";
+      G4Exception("DetectorRegion::Attach()", "MyCode0010", JustWarning, msg);
+      continue;
+    }
+    fRegion->AddRootLogicalVolume(volume);
+  }
+
+  // After all the roots are known, so that another region's root stops
+  // the descent
+  for ( const auto& name : rootVolumes ) {
+    if ( auto volume = store->GetVolume(name, false) ) SetLimits(volume);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorRegion::SetLimits(G4LogicalVolume* volume)
+{
+  volume->SetUserLimits(fLimits);
+  for ( std::size_t i = 0; i < std::size_t(volume->GetNoDaughters()); ++i ) {
+    auto daughter = volume->GetDaughter(i)->GetLogicalVolume();
+    if ( ! daughter->IsRootRegion() ) SetLimits(daughter);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorRegion::SetCut(G4double cut)
+{
+  fCuts->SetProductionCut(cut);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorRegion::SetGammaCut(G4double cut)
+{
+  fCuts->SetProductionCut(cut, "gamma");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorRegion::SetElectronCut(G4double cut)
+{
+  fCuts->SetProductionCut(cut, "e-");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorRegion::SetPositronCut(G4double cut)
+{
+  fCuts->SetProductionCut(cut, "e+");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorRegion::SetMaxStep(G4double step)
+{
+  fLimits->SetMaxAllowedStep(step > 0. ? step : DBL_MAX);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorRegion::SetMaxTrackLength(G4double length)
+{
+  fLimits->SetUserMaxTrackLength(length > 0. ? length : DBL_MAX);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorRegion::SetMaxTime(G4double time)
+{
+  fLimits->SetUserMaxTime(time > 0. ? time : DBL_MAX);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorRegion::SetMinKinEnergy(G4double energy)
+{
+  fLimits->SetUserMinEkine(energy);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
@@ -28,10 +28,24 @@
 /// \brief Implementation of the B4c::EventAction class
 
 #include "EventAction.hh"
+#include "AllocationCounter.hh"
 #include "CalorimeterSD.hh"
 #include "CalorHit.hh"
+#include "Checkpoint.hh"
+#include "CompactOutput.hh"
+#include "EventTimer.hh"
+#include "HDF5Output.hh"
+#include "PMTDigitizer.hh"
+#include "PerfCounters.hh"
+#include "PhotonCounters.hh"
+#include "RunFarm.hh"
+#include "RunMonitor.hh"
+#include "StepProfiler.hh"
+#include "TimeGate.hh"
+#include "TrajectorySampler.hh"
 
 #include "G4AnalysisManager.hh"
+#include "G4DigiManager.hh"
 #include "G4RunManager.hh"
 #include "G4Event.hh"
 #include "G4SDManager.hh"
@@ -43,7 +57,7 @@
 
 namespace B4c
 {
-  int event_counter;
+  G4ThreadLocal int event_counter;
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 EventAction::EventAction()
@@ -56,22 +70,19 @@ EventAction::~EventAction()
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-CalorHitsCollection*
-EventAction::GetHitsCollection(G4int hcID,
-                                  const G4Event* event) const
+const CalorimeterSD* EventAction::GetSD(const G4String& name) const
 {
-  auto hitsCollection
-    = static_cast<CalorHitsCollection*>(
-        event->GetHCofThisEvent()->GetHC(hcID));
+  auto sd = static_cast<const CalorimeterSD*>(
+    G4SDManager::GetSDMpointer()->FindSensitiveDetector(name, false));
 
-  if ( ! hitsCollection ) {
+  if ( ! sd ) {
     G4ExceptionDescription msg;
-    msg << "Cannot access hitsCollection ID " << hcID;
-    G4Exception("EventAction::GetHitsCollection()",
+    msg << "Cannot access sensitive detector " << name;
+    G4Exception("EventAction::GetSD()",
       "MyCode0003", FatalException, msg);
   }
 
-  return hitsCollection;
+  return sd;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -85,30 +96,42 @@ void EventAction::PrintEventStatistics(
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void EventAction::BeginOfEventAction(const G4Event* /*event*/)
+void EventAction::BeginOfEventAction(const G4Event* event)
 {
   event_counter = 0;
+  PhotonCounters::Instance()->BeginOfEvent();
+  TrajectorySampler::Instance()->BeginOfEvent(event);
+  auto profiler = StepProfiler::Instance();
+  if ( profiler->IsEnabled() ) profiler->BeginOfEvent();
+
+  if ( AllocationCounter::IsEnabled() ) {
+    fAllocationsAtBegin = AllocationCounter::GetCount();
+    fPoolGrowthsAtBegin = fAbsoSD ? fAbsoSD->GetNofPoolGrowths()
+                                    + fGapSD->GetNofPoolGrowths() : 0;
+  }
+
+  // The event is tracked from here to EndOfEventAction()
+  PerfCounters::Instance()->Start(PerfCounters::kTracking);
 } 
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void EventAction::EndOfEventAction(const G4Event* event)
 {
-  // Get hits collections IDs (only once)
-  if ( fAbsHCID == -1 ) {
-    fAbsHCID
-      = G4SDManager::GetSDMpointer()->GetCollectionID("AbsorberHitsCollection");
-    fGapHCID
-      = G4SDManager::GetSDMpointer()->GetCollectionID("GapHitsCollection");
-  }
+  PerfCounters::Instance()->Stop(PerfCounters::kTracking);
+  PerfCounters::Scope perfScope(PerfCounters::kEndOfEvent);
 
-  // Get hits collections
-  auto absoHC = GetHitsCollection(fAbsHCID, event);
-  auto gapHC = GetHitsCollection(fGapHCID, event);
+  // Get the sensitive detectors holding the hits (only once)
+  if ( ! fAbsoSD ) {
+    fAbsoSD = GetSD("AbsorberSD");
+    fGapSD = GetSD("GapSD");
+  }
 
   // Get hit with total values
-  auto absoHit = (*absoHC)[absoHC->entries()-1];
-  auto gapHit = (*gapHC)[gapHC->entries()-1];
+  const auto& absoHits = fAbsoSD->GetCalorHits();
+  const auto& gapHits = fGapSD->GetCalorHits();
+  auto absoHit = &absoHits[absoHits.GetSize()-1];
+  auto gapHit = &gapHits[gapHits.GetSize()-1];
 
   // Print per event (modulo n)
   //
@@ -120,6 +143,13 @@ void EventAction::EndOfEventAction(const G4Event* event)
     PrintEventStatistics(
       absoHit->GetEdep(), absoHit->GetTrackLength(),
       gapHit->GetEdep(), gapHit->GetTrackLength());
+
+    if ( TimeGate::Instance()->IsEnabled() ) {
+      G4cout << "---> Event " << eventID << ": "
+             << PhotonCounters::Instance()->GetEventValue(
+                  PhotonCounters::kCulled)
+             << " photons culled by the time gate" << G4endl;
+    }
   }
 
   // Fill histograms, ntuple
@@ -130,6 +160,78 @@ void EventAction::EndOfEventAction(const G4Event* event)
   if (event_counter > 1000){
     analysisManager->FillH1(0,event_counter);
   }
+
+  // Per-event photon budget
+  auto counters = PhotonCounters::Instance();
+  if ( counters->GetWriteNtuple() ) {
+    analysisManager->FillNtupleIColumn(3, 0,
+      eventID + Checkpoint::GetEventOffset());
+    for ( G4int i = 0; i < PhotonCounters::kNofCounters; ++i ) {
+      analysisManager->FillNtupleIColumn(3, i+1,
+        G4int(counters->GetEventValue(PhotonCounters::Counter(i))));
+    }
+    analysisManager->AddNtupleRow(3);
+  }
+
+  // Compact photon output (/B4/output/photons compact or both)
+  PerfCounters::Instance()->Start(PerfCounters::kOutput);
+  auto compact = CompactOutput::Instance();
+  if ( compact->IsOpen() ) {
+    compact->AddHits(fAbsoSD->GetPhotonHits());
+    compact->AddHits(fGapSD->GetPhotonHits());
+    auto vertex = event->GetPrimaryVertex();
+    compact->WriteEvent(eventID + Checkpoint::GetEventOffset(),
+                        vertex ? vertex->GetT0() : 0.);
+  }
+
+  // HDF5 photon output (/B4/output/photons hdf5)
+  auto hdf5 = HDF5Output::Instance();
+  if ( hdf5->IsOpen() ) {
+    hdf5->AddHits(eventID + Checkpoint::GetEventOffset(),
+                  fAbsoSD->GetPhotonHits());
+    hdf5->AddHits(eventID + Checkpoint::GetEventOffset(),
+                  fGapSD->GetPhotonHits());
+  }
+  PerfCounters::Instance()->Stop(PerfCounters::kOutput);
+
+  // Digitise the PMT response (no-op unless /B4/digi/enable is set)
+  G4DigiManager::GetDMpointer()->Digitize("PMTDigitizer");
+
+  // Publish the event to the live monitor
+  auto monitor = RunMonitor::Instance();
+  if ( monitor && monitor->IsEnabled() ) monitor->EndOfEvent();
+
+  // Progress of a run farm shard (no-op otherwise)
+  RunFarm::EndOfEvent();
+
+  // Wall time, peak stack depth and photons created of the event
+  G4long nofPhotons = 0;
+  for ( G4int i = PhotonCounters::kCreatedScintQD;
+        i <= PhotonCounters::kCreatedOther; ++i ) {
+    nofPhotons += counters->GetEventValue(PhotonCounters::Counter(i));
+  }
+  auto timer = EventTimer::Instance();
+  timer->EndOfEvent(eventID + Checkpoint::GetEventOffset(), nofPhotons);
+  if ( timer->GetWriteNtuple() ) {
+    analysisManager->FillNtupleIColumn(4, 0,
+      eventID + Checkpoint::GetEventOffset());
+    analysisManager->FillNtupleDColumn(4, 1, timer->GetWallTime());
+    analysisManager->FillNtupleIColumn(4, 2, timer->GetPeakStackDepth());
+    analysisManager->FillNtupleIColumn(4, 3, G4int(nofPhotons));
+    analysisManager->AddNtupleRow(4);
+  }
+
+  // Heap traffic of the event (B4_COUNT_ALLOCATIONS builds only)
+  if ( AllocationCounter::IsEnabled()
+       && ( printModulo > 0 ) && ( eventID % printModulo == 0 ) ) {
+    auto poolGrowths = fAbsoSD->GetNofPoolGrowths()
+                     + fGapSD->GetNofPoolGrowths() - fPoolGrowthsAtBegin;
+    G4cout
+      << "---> Event " << eventID << ": "
+      << AllocationCounter::GetCount() - fAllocationsAtBegin
+      << " heap allocations, " << poolGrowths << " hit pool reallocations"
+      << G4endl;
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,101 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file EventSeeder.cc
+/// \brief Implementation of the B4c::EventSeeder class
+
+#include "EventSeeder.hh"
+#include "Checkpoint.hh"
+
+#include "G4GenericMessenger.hh"
+#include "Randomize.hh"
+
+namespace B4c
+{
+
+G4ThreadLocal EventSeeder* EventSeeder::fgInstance = nullptr;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EventSeeder* EventSeeder::Instance()
+{
+  if ( ! fgInstance ) {
+    fgInstance = new EventSeeder();
+  }
+  return fgInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EventSeeder::EventSeeder()
+{
+  fMessenger = new G4GenericMessenger(this, "/B4/random/",
+                                      "Random seeding control");
+
+  auto& enableCmd = fMessenger->DeclareProperty("perEventSeeding", fEnabled,
+    "Reseed each event from a hash of (run seed, event ID).");
+  enableCmd.SetParameterName("flag", true);
+  enableCmd.SetDefaultValue("true");
+
+  auto& seedCmd = fMessenger->DeclareProperty("runSeed", fRunSeed,
+    "Run seed combined with the event ID in the per-event seeding.");
+  seedCmd.SetParameterName("seed", false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EventSeeder::~EventSeeder()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::uint64_t EventSeeder::Hash(std::uint64_t value)
+{
+  // splitmix64 finaliser
+  value += 0x9e3779b97f4a7c15ull;
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+  return value ^ (value >> 31);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventSeeder::Seed(G4int eventID) const
+{
+  auto key = std::uint64_t(G4long(eventID) + Checkpoint::GetEventOffset());
+  auto hash = Hash(Hash(std::uint64_t(std::uint32_t(fRunSeed))) ^ key);
+
+  // Two positive 31-bit seeds, as drawn by the run manager, zero-terminated
+  long seeds[3] = { long(hash & 0x7fffffff) | 1,
+                    long((hash >> 32) & 0x7fffffff) | 1, 0 };
+  G4Random::setTheSeeds(seeds, -1);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
@@ -0,0 +1,246 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file EventTimer.cc
+/// \brief Implementation of the B4c::EventTimer class
+
+#include "EventTimer.hh"
+
+#include "G4AutoLock.hh"
+#include "G4GenericMessenger.hh"
+#include "G4Threading.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace B4c
+{
+
+namespace
+{
+  // Slowest events and totals merged from all threads
+  G4Mutex reportMutex = G4MUTEX_INITIALIZER;
+  std::vector<EventTimer::SlowEvent> reportEvents;
+  G4long reportNofEvents = 0;
+  G4double reportWallTime = 0.;
+
+  // Order of the min-heap of the slowest events
+  G4bool IsSlower(const EventTimer::SlowEvent& a,
+                  const EventTimer::SlowEvent& b)
+  {
+    return a.wallTime > b.wallTime;
+  }
+}
+
+G4ThreadLocal EventTimer* EventTimer::fgInstance = nullptr;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EventTimer* EventTimer::Instance()
+{
+  if ( ! fgInstance ) {
+    fgInstance = new EventTimer();
+  }
+  return fgInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EventTimer::EventTimer()
+{
+  fMessenger = new G4GenericMessenger(this, "/B4/timing/",
+                                      "Per-event timing and slow events");
+
+  auto& ntupleCmd = fMessenger->DeclareProperty("writeNtuple", fWriteNtuple,
+    "Write the wall time, peak stack depth and photons created of each "
+    "event to the Timing ntuple.");
+  ntupleCmd.SetParameterName("flag", true);
+  ntupleCmd.SetDefaultValue("true");
+
+  auto& slowCmd = fMessenger->DeclareProperty("slowEvents", fNofSlowEvents,
+    "Report the K slowest events and save their random states.");
+  slowCmd.SetParameterName("K", false);
+  slowCmd.SetRange("K>=0");
+
+  auto& prefixCmd = fMessenger->DeclareProperty("slowPrefix", fSlowPrefix,
+    "Prefix of the <prefix>_run<R>_event<N>.rndm random state files.");
+  prefixCmd.SetParameterName("prefix", false);
+
+  auto& replayCmd = fMessenger->DeclareMethod("replay",
+    &EventTimer::SetReplay,
+    "Start each event from the random state saved in the file, "
+    "none to stop.");
+  replayCmd.SetParameterName("file", false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EventTimer::~EventTimer()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventTimer::SetReplay(const G4String& fileName)
+{
+  fReplayState.clear();
+  if ( fileName == "none" ) return;
+
+  std::ifstream file(fileName);
+  std::ostringstream state;
+  state << file.rdbuf();
+  if ( ! file || state.str().empty() ) {
+    G4ExceptionDescription msg;
+    msg << "Cannot read the random state " << fileName << ", no replay.";
+    G4Exception("EventTimer::SetReplay()", "MyCode0014", JustWarning, msg);
+    return;
+  }
+  fReplayState = state.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventTimer::BeginOfRun()
+{
+  fNofEvents = 0;
+  fTotalWallTime = 0.;
+  fSlowEvents.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventTimer::BeginOfEvent()
+{
+  if ( ! fReplayState.empty() ) {
+    std::istringstream state(fReplayState);
+    G4Random::restoreFullState(state);
+  }
+  if ( fNofSlowEvents > 0 ) {
+    std::ostringstream state;
+    G4Random::saveFullState(state);
+    fRandomState = state.str();
+  }
+  fPeakStackDepth = 0;
+  fStartTime = std::chrono::steady_clock::now();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventTimer::EndOfEvent(G4int eventID, G4long nofPhotons)
+{
+  std::chrono::duration<G4double> wallTime
+    = std::chrono::steady_clock::now() - fStartTime;
+  fWallTime = wallTime.count();
+  ++fNofEvents;
+  fTotalWallTime += fWallTime;
+
+  // Keep the K slowest events, the fastest of them on top of the heap
+  if ( fNofSlowEvents <= 0 ) return;
+  auto size = fSlowEvents.size();
+  if ( size == std::size_t(fNofSlowEvents) ) {
+    if ( fWallTime <= fSlowEvents.front().wallTime ) return;
+    std::pop_heap(fSlowEvents.begin(), fSlowEvents.end(), IsSlower);
+    fSlowEvents.pop_back();
+  }
+  fSlowEvents.push_back({fWallTime, eventID, G4Threading::G4GetThreadId(),
+                         fPeakStackDepth, nofPhotons,
+                         std::move(fRandomState)});
+  std::push_heap(fSlowEvents.begin(), fSlowEvents.end(), IsSlower);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventTimer::EndOfRun(G4bool isMaster, G4int runID)
+{
+  G4AutoLock lock(&reportMutex);
+  reportNofEvents += fNofEvents;
+  reportWallTime += fTotalWallTime;
+  std::move(fSlowEvents.begin(), fSlowEvents.end(),
+            std::back_inserter(reportEvents));
+  fSlowEvents.clear();
+
+  if ( ! isMaster ) return;
+  if ( fNofSlowEvents > 0 && ! reportEvents.empty() ) WriteReport(runID);
+
+  reportEvents.clear();
+  reportNofEvents = 0;
+  reportWallTime = 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventTimer::WriteReport(G4int runID) const
+{
+  std::sort(reportEvents.begin(), reportEvents.end(), IsSlower);
+  if ( reportEvents.size() > std::size_t(fNofSlowEvents) ) {
+    reportEvents.resize(fNofSlowEvents);
+  }
+  auto mean = reportWallTime / reportNofEvents;
+
+  G4cout
+    << G4endl
+    << "--------------------------- Slowest events ---------------------------"
+    << G4endl
+    << " Rank     Event Thread  Wall [s] x mean Peak stack    Photons"
+    << "  Random state" << G4endl
+    << std::fixed;
+  G4int rank = 0;
+  for ( const auto& event : reportEvents ) {
+    auto fileName = fSlowPrefix + "_run" + std::to_string(runID)
+                  + "_event" + std::to_string(event.eventID) + ".rndm";
+    std::ofstream file(fileName);
+    file << event.randomState;
+    if ( ! file ) {
+      G4ExceptionDescription msg;
+      msg << "Cannot write " << fileName;
+      G4Exception("EventTimer::WriteReport()", "MyCode0014", JustWarning, msg);
+    }
+    G4cout
+      << std::setw(5) << ++rank << std::setw(10) << event.eventID
+      << std::setw(7) << event.threadID
+      << std::setw(10) << std::setprecision(3) << event.wallTime
+      << std::setw(7) << std::setprecision(1)
+      << ( mean > 0. ? event.wallTime / mean : 0. )
+      << std::setw(11) << event.peakStackDepth
+      << std::setw(11) << event.nofPhotons << "  " << fileName << G4endl;
+  }
+  G4cout
+    << " Mean wall time " << std::setprecision(4) << mean << " s over "
+    << reportNofEvents << " events; replay one with /B4/timing/replay"
+    << G4endl
+    << "----------------------------------------------------------------------"
+    << G4endl;
+  G4cout.unsetf(std::ios::fixed);
+  G4cout << std::setprecision(6);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
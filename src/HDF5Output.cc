@@ -0,0 +1,376 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file HDF5Output.cc
+/// \brief Implementation of the B4c::HDF5Output class
+
+#include "HDF5Output.hh"
+#include "OutputSchema.hh"
+#include "PhotonTrackInfo.hh"
+
+#include "G4AutoLock.hh"
+#include "G4GenericMessenger.hh"
+
+#include <cstring>
+
+#ifdef B4_WITH_HDF5
+#include <hdf5.h>
+#include <zlib.h>
+#endif
+
+namespace B4c
+{
+
+namespace {
+  // The HDF5 library is not reentrant: its calls are serialised
+  G4Mutex hdf5Mutex = G4MUTEX_INITIALIZER;
+}
+
+G4ThreadLocal HDF5Output* HDF5Output::fgInstance = nullptr;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+HDF5Output* HDF5Output::Instance()
+{
+  if ( ! fgInstance ) {
+    fgInstance = new HDF5Output();
+  }
+  return fgInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool HDF5Output::IsAvailable()
+{
+#ifdef B4_WITH_HDF5
+  return true;
+#else
+  return false;
+#endif
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+HDF5Output::HDF5Output()
+{
+  fMessenger = new G4GenericMessenger(this, "/B4/hdf5/",
+                                      "HDF5 photon output");
+
+  auto& chunkCmd = fMessenger->DeclareProperty("chunkRows", fChunkRows,
+    "Rows per chunk of the photon datasets.");
+  chunkCmd.SetParameterName("rows", false);
+  chunkCmd.SetRange("rows>0");
+  chunkCmd.AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  auto& bufferCmd = fMessenger->DeclareProperty("bufferChunks",
+    fBufferChunks, "Chunks buffered in memory before each write.");
+  bufferCmd.SetParameterName("chunks", false);
+  bufferCmd.SetRange("chunks>0");
+  bufferCmd.AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  auto& compressionCmd = fMessenger->DeclareProperty("compression",
+    fCompression, "Deflate level of the chunks, 0 for no compression.");
+  compressionCmd.SetParameterName("level", false);
+  compressionCmd.SetRange("level>=0 && level<=9");
+  compressionCmd.AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  auto& shuffleCmd = fMessenger->DeclareProperty("shuffle", fShuffle,
+    "Byte-shuffle the chunks before the compression.");
+  shuffleCmd.SetParameterName("flag", true);
+  shuffleCmd.SetDefaultValue("true");
+  shuffleCmd.AvailableForStates(G4State_PreInit, G4State_Idle);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+HDF5Output::~HDF5Output()
+{
+  Close();
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool HDF5Output::Open(const G4String& fileName)
+{
+  Close();
+
+#ifdef B4_WITH_HDF5
+  const auto& schema = GetNtupleSchemas()[0];
+  if ( schema.columns.size() != 4 + PhotonTrackInfo::kNofPaths ) {
+    G4Exception("HDF5Output::Open()", "MyCode0012", FatalException,
+                "The photon ntuple layout is not the one written.");
+    return false;
+  }
+
+  fFileName = fileName;
+  fOpenChunkRows = fChunkRows;
+  fOpenCompression = fCompression;
+  fOpenShuffle = fShuffle;
+  fNofRows = 0;
+  fNofBufferedRows = 0;
+
+  G4AutoLock lock(&hdf5Mutex);
+  if ( fOpenCompression > 0 && H5Zfilter_avail(H5Z_FILTER_DEFLATE) <= 0 ) {
+    G4ExceptionDescription msg;
+    msg << "No deflate filter in the HDF5 library, " << fileName
+        << " is not compressed.";
+    G4Exception("HDF5Output::Open()", "MyCode0012", JustWarning, msg);
+    fOpenCompression = 0;
+  }
+
+  fFile = H5Fcreate(fileName.c_str(), H5F_ACC_TRUNC,
+                    H5P_DEFAULT, H5P_DEFAULT);
+  if ( fFile < 0 ) {
+    lock.unlock();
+    Failed("Cannot create");
+    return false;
+  }
+  fGroup = H5Gcreate2(fFile, schema.name.c_str(),
+                      H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+
+  // Extendible datasets with the filters applied to the direct writes
+  hsize_t size = 0;
+  hsize_t maxSize = H5S_UNLIMITED;
+  hsize_t chunkSize = fOpenChunkRows;
+  auto space = H5Screate_simple(1, &size, &maxSize);
+  auto properties = H5Pcreate(H5P_DATASET_CREATE);
+  H5Pset_chunk(properties, 1, &chunkSize);
+  if ( fOpenShuffle ) H5Pset_shuffle(properties);
+  if ( fOpenCompression > 0 ) H5Pset_deflate(properties, fOpenCompression);
+
+  G4bool ok = fGroup >= 0;
+  fColumns.clear();
+  for ( const auto& ntupleColumn : schema.columns ) {
+    Column column;
+    column.name = ntupleColumn.name;
+    column.type = ntupleColumn.type;
+    auto type = ( column.type == 'I' ) ? H5T_NATIVE_INT : H5T_NATIVE_DOUBLE;
+    column.elementSize = H5Tget_size(type);
+    column.buffer.reserve(
+      std::size_t(fBufferChunks) * fOpenChunkRows * column.elementSize);
+    if ( ok ) {
+      column.dataset = H5Dcreate2(fGroup, column.name.c_str(), type, space,
+                                  H5P_DEFAULT, properties, H5P_DEFAULT);
+      ok = column.dataset >= 0;
+    }
+    fColumns.push_back(std::move(column));
+  }
+  H5Pclose(properties);
+  H5Sclose(space);
+  lock.unlock();
+
+  if ( ! ok ) {
+    Failed("Cannot create the photon datasets in");
+    return false;
+  }
+  return true;
+#else
+  G4ExceptionDescription msg;
+  msg << "Built without HDF5, no " << fileName
+      << "; the photons are kept in the ntuple.";
+  G4Exception("HDF5Output::Open()", "MyCode0012", JustWarning, msg);
+  return false;
+#endif
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void HDF5Output::Close()
+{
+  if ( ! IsOpen() ) return;
+  Flush(true);
+  if ( ! IsOpen() ) return;
+
+#ifdef B4_WITH_HDF5
+  G4AutoLock lock(&hdf5Mutex);
+  for ( auto& column : fColumns ) {
+    if ( column.dataset >= 0 ) H5Dclose(column.dataset);
+  }
+  if ( fGroup >= 0 ) H5Gclose(fGroup);
+  auto status = H5Fclose(fFile);
+  lock.unlock();
+#else
+  G4int status = 0;
+#endif
+  fColumns.clear();
+  fGroup = -1;
+  fFile = -1;
+  if ( status < 0 ) Failed("Cannot close");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void HDF5Output::Append(Column& column, G4double value)
+{
+  auto& buffer = column.buffer;
+  auto offset = buffer.size();
+  buffer.resize(offset + column.elementSize);
+  if ( column.type == 'I' ) {
+    G4int intValue = G4int(value);
+    std::memcpy(&buffer[offset], &intValue, sizeof(intValue));
+  }
+  else {
+    std::memcpy(&buffer[offset], &value, sizeof(value));
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void HDF5Output::AddHits(G4int eventID, const PhotonHits& hits)
+{
+  if ( ! IsOpen() ) return;
+
+  // Same columns as the photon ntuple, see OutputSchema.cc
+  for ( const auto& hit : hits ) {
+    auto column = fColumns.begin();
+    Append(*column++, eventID);
+    Append(*column++, hit.GetWavelength());
+    Append(*column++, hit.GetTime());
+    for ( auto pathLength : hit.GetPathLengths() ) {
+      Append(*column++, pathLength);
+    }
+    Append(*column++, hit.GetCreator());
+    ++fNofBufferedRows;
+  }
+
+  if ( fNofBufferedRows >= std::size_t(fBufferChunks) * fOpenChunkRows ) {
+    Flush(false);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void HDF5Output::Flush(G4bool all)
+{
+#ifdef B4_WITH_HDF5
+  // Filter the full chunks out of the lock, as the HDF5 pipeline would:
+  // byte shuffle, then deflate (zlib stream)
+  auto nofChunks = fNofBufferedRows / fOpenChunkRows;
+  fChunks.resize(fColumns.size() * nofChunks);
+  for ( std::size_t c = 0; c < fColumns.size(); ++c ) {
+    const auto& column = fColumns[c];
+    auto chunkBytes = fOpenChunkRows * column.elementSize;
+    for ( std::size_t k = 0; k < nofChunks; ++k ) {
+      auto data = &column.buffer[k * chunkBytes];
+      auto& chunk = fChunks[c * nofChunks + k];
+      if ( fOpenShuffle ) {
+        fShuffled.resize(chunkBytes);
+        for ( std::size_t i = 0; i < fOpenChunkRows; ++i ) {
+          for ( std::size_t j = 0; j < column.elementSize; ++j ) {
+            fShuffled[j * fOpenChunkRows + i]
+              = data[i * column.elementSize + j];
+          }
+        }
+        data = &fShuffled[0];
+      }
+      if ( fOpenCompression > 0 ) {
+        uLongf size = compressBound(chunkBytes);
+        chunk.resize(size);
+        compress2(reinterpret_cast<Bytef*>(&chunk[0]), &size,
+                  reinterpret_cast<const Bytef*>(data), chunkBytes,
+                  fOpenCompression);
+        chunk.resize(size);
+      }
+      else {
+        chunk.assign(data, chunkBytes);
+      }
+    }
+  }
+
+  // Extend the datasets and write the chunks; with all, the last partial
+  // chunk goes through the HDF5 pipeline
+  auto nofRows = all ? fNofBufferedRows : nofChunks * fOpenChunkRows;
+  if ( nofRows == 0 ) return;
+  G4AutoLock lock(&hdf5Mutex);
+  G4bool ok = true;
+  hsize_t size = fNofRows + nofRows;
+  for ( std::size_t c = 0; c < fColumns.size() && ok; ++c ) {
+    const auto& column = fColumns[c];
+    ok = H5Dset_extent(column.dataset, &size) >= 0;
+    for ( std::size_t k = 0; k < nofChunks && ok; ++k ) {
+      hsize_t offset = fNofRows + k * fOpenChunkRows;
+      const auto& chunk = fChunks[c * nofChunks + k];
+      ok = H5Dwrite_chunk(column.dataset, H5P_DEFAULT, 0, &offset,
+                          chunk.size(), chunk.data()) >= 0;
+    }
+    hsize_t tailRows = nofRows - nofChunks * fOpenChunkRows;
+    if ( tailRows > 0 && ok ) {
+      hsize_t offset = fNofRows + nofChunks * fOpenChunkRows;
+      auto type = ( column.type == 'I' ) ? H5T_NATIVE_INT : H5T_NATIVE_DOUBLE;
+      auto fileSpace = H5Dget_space(column.dataset);
+      H5Sselect_hyperslab(fileSpace, H5S_SELECT_SET, &offset, nullptr,
+                          &tailRows, nullptr);
+      auto memorySpace = H5Screate_simple(1, &tailRows, nullptr);
+      ok = H5Dwrite(column.dataset, type, memorySpace, fileSpace, H5P_DEFAULT,
+                    &column.buffer[nofChunks * fOpenChunkRows
+                                   * column.elementSize]) >= 0;
+      H5Sclose(memorySpace);
+      H5Sclose(fileSpace);
+    }
+  }
+  lock.unlock();
+
+  if ( ! ok ) {
+    Failed("Cannot write the photons to");
+    return;
+  }
+  fNofRows += nofRows;
+  fNofBufferedRows -= nofRows;
+  for ( auto& column : fColumns ) {
+    column.buffer.erase(column.buffer.begin(),
+      column.buffer.begin() + nofRows * column.elementSize);
+  }
+#else
+  (void)all;
+#endif
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void HDF5Output::Failed(const char* what)
+{
+  G4ExceptionDescription msg;
+  msg << what << " " << fFileName << ", no HDF5 photon output.";
+  G4Exception("HDF5Output", "MyCode0012", JustWarning, msg);
+
+#ifdef B4_WITH_HDF5
+  G4AutoLock lock(&hdf5Mutex);
+  for ( auto& column : fColumns ) {
+    if ( column.dataset >= 0 ) H5Dclose(column.dataset);
+  }
+  if ( fGroup >= 0 ) H5Gclose(fGroup);
+  if ( fFile >= 0 ) H5Fclose(fFile);
+#endif
+  fColumns.clear();
+  fNofBufferedRows = 0;
+  fGroup = -1;
+  fFile = -1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
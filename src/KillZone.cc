@@ -0,0 +1,159 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file KillZone.cc
+/// \brief Implementation of the B4c::KillZone class
+
+#include "KillZone.hh"
+
+#include "G4AccumulableManager.hh"
+#include "G4GenericMessenger.hh"
+#include "G4Gamma.hh"
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4Neutron.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4Track.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4UnitsTable.hh"
+
+#include <cmath>
+#include <iomanip>
+
+namespace B4c
+{
+
+G4ThreadLocal KillZone* KillZone::fgInstance = nullptr;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+KillZone* KillZone::Instance()
+{
+  if ( ! fgInstance ) {
+    fgInstance = new KillZone();
+  }
+  return fgInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+KillZone::KillZone()
+{
+  auto accumulableManager = G4AccumulableManager::Instance();
+  for ( G4int i = 0; i < kNofCategories; ++i ) {
+    accumulableManager->RegisterAccumulable(fNofKilled[i]);
+    accumulableManager->RegisterAccumulable(fEnergy[i]);
+  }
+
+  fMessenger = new G4GenericMessenger(this, "/B4/killzone/",
+                                      "Kill zone outside the black box");
+
+  auto& enableCmd = fMessenger->DeclareProperty("enable", fEnabled,
+    "Kill the secondary tracks (except muons and optical photons) "
+    "leaving the black box.");
+  enableCmd.SetParameterName("flag", true);
+  enableCmd.SetDefaultValue("true");
+
+  auto& envelopeCmd = fMessenger->DeclarePropertyWithUnit("envelope", "cm",
+    fEnvelope, "Half-lengths of the box outside which the tracks are "
+    "killed (0: the black box).");
+  envelopeCmd.SetParameterName("halfX", "halfY", "halfZ", false);
+
+  auto& centreCmd = fMessenger->DeclarePropertyWithUnit("centre", "cm",
+    fCentre, "Centre of the envelope.");
+  centreCmd.SetParameterName("x", "y", "z", false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+KillZone::~KillZone()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool KillZone::IsToBeKilled(const G4Track* track,
+                              const G4VPhysicalVolume* volume) const
+{
+  if ( track->GetParentID() == 0 ) return false;
+
+  auto particle = track->GetDefinition();
+  if ( particle == G4OpticalPhoton::Definition() ) return false;
+  if ( std::abs(particle->GetPDGEncoding()) == 13 ) return false;
+
+  if ( ! fWorldVolume ) {
+    fWorldVolume
+      = G4LogicalVolumeStore::GetInstance()->GetVolume("logicWorld", false);
+  }
+  if ( ! volume || volume->GetLogicalVolume() != fWorldVolume ) return false;
+
+  if ( fEnvelope.x() <= 0. ) return true;
+  auto local = track->GetPosition() - fCentre;
+  return std::abs(local.x()) > fEnvelope.x()
+      || std::abs(local.y()) > fEnvelope.y()
+      || std::abs(local.z()) > fEnvelope.z();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void KillZone::Add(const G4Track* track)
+{
+  auto particle = track->GetDefinition();
+  auto category = kOther;
+  if ( particle == G4Gamma::Definition() ) category = kGamma;
+  else if ( particle == G4Neutron::Definition() ) category = kNeutron;
+  else if ( std::abs(particle->GetPDGEncoding()) == 11 ) category = kElectron;
+
+  fNofKilled[category] += 1;
+  fEnergy[category] += track->GetKineticEnergy();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void KillZone::Print() const
+{
+  static const char* names[kNofCategories]
+    = { "gammas", "neutrons", "electrons", "others" };
+
+  G4cout
+    << G4endl
+    << "--------------------------- Kill zone ---------------------------"
+    << G4endl;
+  for ( G4int i = 0; i < kNofCategories; ++i ) {
+    G4cout << " " << std::left << std::setw(12) << names[i] << std::right
+           << std::setw(12) << fNofKilled[i].GetValue() << " killed, "
+           << std::setw(7) << G4BestUnit(fEnergy[i].GetValue(), "Energy")
+           << G4endl;
+  }
+  G4cout
+    << "-----------------------------------------------------------------"
+    << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
@@ -0,0 +1,67 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file KillZoneSD.cc
+/// \brief Implementation of the B4c::KillZoneSD class
+
+#include "KillZoneSD.hh"
+#include "KillZone.hh"
+
+#include "G4Step.hh"
+#include "G4StepPoint.hh"
+#include "G4Track.hh"
+
+namespace B4c
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+KillZoneSD::KillZoneSD(const G4String& name)
+ : G4VSensitiveDetector(name),
+   fKillZone(KillZone::Instance())
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool KillZoneSD::ProcessHits(G4Step* step, G4TouchableHistory* /*history*/)
+{
+  if ( ! fKillZone->IsEnabled() ) return false;
+
+  // The track is at the end of its step, which may have brought it back
+  // into the box
+  auto track = step->GetTrack();
+  if ( track->GetTrackStatus() != fAlive ) return false;
+  auto volume = step->GetPostStepPoint()->GetPhysicalVolume();
+  if ( ! fKillZone->IsToBeKilled(track, volume) ) return false;
+
+  fKillZone->Add(track);
+  track->SetTrackStatus(fStopAndKill);
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
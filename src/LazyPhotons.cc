@@ -0,0 +1,427 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file LazyPhotons.cc
+/// \brief Implementation of the B4c::LazyPhotons class
+
+#include "LazyPhotons.hh"
+#include "PhotonSources.hh"
+
+#include "G4Cerenkov.hh"
+#include "G4DynamicParticle.hh"
+#include "G4EventManager.hh"
+#include "G4GenericMessenger.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4OpticalParameters.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4PhysicsTable.hh"
+#include "G4PhysicsVector.hh"
+#include "G4ProcessManager.hh"
+#include "G4ProcessTable.hh"
+#include "G4Scintillation.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4TrackVector.hh"
+#include "G4PhysicalConstants.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace B4c
+{
+
+namespace
+{
+  // Emission time after the energy deposit, as in G4Scintillation
+  G4double SampleEmissionTime(G4double riseTime, G4double decayTime)
+  {
+    if ( riseTime == 0. ) {
+      return -decayTime * std::log(G4UniformRand());
+    }
+    auto d = (riseTime + decayTime) / decayTime;
+    while ( true ) {
+      auto t = -decayTime * std::log(1. - G4UniformRand());
+      auto envelope = d * std::exp(-t / decayTime) / decayTime;
+      auto density = std::exp(-t / decayTime) * (1. - std::exp(-t / riseTime))
+                   / decayTime / decayTime * (riseTime + decayTime);
+      if ( G4UniformRand() * envelope <= density ) return t;
+    }
+  }
+
+  G4Track* MakePhoton(const LazyPhotons::EmissionRecord& record,
+                      const G4VProcess* creator, G4double energy,
+                      const G4ThreeVector& direction,
+                      const G4ThreeVector& polarization,
+                      G4double time, const G4ThreeVector& position)
+  {
+    auto photon
+      = new G4DynamicParticle(G4OpticalPhoton::Definition(), direction, energy);
+    photon->SetPolarization(polarization);
+
+    auto track = new G4Track(photon, time, position);
+    track->SetTouchableHandle(record.touchable);
+    track->SetParentID(record.parentID);
+    track->SetCreatorProcess(creator);
+    return track;
+  }
+}
+
+G4ThreadLocal LazyPhotons* LazyPhotons::fgInstance = nullptr;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+LazyPhotons* LazyPhotons::Instance()
+{
+  if ( ! fgInstance ) {
+    fgInstance = new LazyPhotons();
+  }
+  return fgInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+LazyPhotons::LazyPhotons()
+{
+  fMessenger = new G4GenericMessenger(this, "/B4/lazy/",
+                                      "Lazy optical photon generation");
+
+  auto& enableCmd = fMessenger->DeclareMethod("enable",
+    &LazyPhotons::SetEnabled,
+    "Record compact emission records instead of stacking the scintillation "
+    "and Cerenkov photons; use before /run/initialize.");
+  enableCmd.SetParameterName("flag", true);
+  enableCmd.SetDefaultValue("true");
+  enableCmd.AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  auto& batchCmd = fMessenger->DeclareProperty("batch", fBatchSize,
+    "Maximum number of photons materialised when the stack is empty.");
+  batchCmd.SetParameterName("photons", false);
+  batchCmd.SetRange("photons>0");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+LazyPhotons::~LazyPhotons()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LazyPhotons::SetEnabled(G4bool enabled)
+{
+  fEnabled = enabled;
+  fProcessesFound = false;
+
+  // The parameters are shared and locked on the workers
+  auto params = G4OpticalParameters::Instance();
+  params->SetScintStackPhotons(! enabled);
+  params->SetCerenkovStackPhotons(! enabled);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LazyPhotons::FindProcesses()
+{
+  auto table = G4ProcessTable::GetProcessTable();
+  fScintillation
+    = dynamic_cast<G4Scintillation*>(table->FindProcess("Scintillation", "e-"));
+  fCerenkov = dynamic_cast<G4Cerenkov*>(table->FindProcess("Cerenkov", "e-"));
+
+  // A process still stacking its photons (lazy mode enabled after
+  // /run/initialize) must not be recorded a second time
+  if ( fScintillation && fScintillation->GetStackPhotons() ) {
+    fScintillation = nullptr;
+  }
+  if ( fCerenkov && fCerenkov->GetStackPhotons() ) {
+    fCerenkov = nullptr;
+  }
+  fActivation.clear();
+  fProcessesFound = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::pair<G4bool, G4bool>
+LazyPhotons::GetActivation(const G4ParticleDefinition* particle)
+{
+  auto it = fActivation.find(particle);
+  if ( it != fActivation.end() ) return it->second;
+
+  // GetNumPhotons() is only refreshed for the particles the process is
+  // attached to
+  auto manager = particle->GetProcessManager();
+  auto isActive = [manager](G4VProcess* process) {
+    return process && manager && manager->GetProcessIndex(process) >= 0
+        && manager->GetProcessActivation(process);
+  };
+  auto activation
+    = std::make_pair(isActive(fScintillation), isActive(fCerenkov));
+  fActivation[particle] = activation;
+  return activation;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LazyPhotons::Clear()
+{
+  fRecords.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LazyPhotons::RecordStep(const G4Step* step)
+{
+  if ( ! fProcessesFound ) FindProcesses();
+
+  auto track = step->GetTrack();
+  auto activation = GetActivation(track->GetDefinition());
+  if ( ! activation.first && ! activation.second ) return;
+
+  auto preStep = step->GetPreStepPoint();
+  auto postStep = step->GetPostStepPoint();
+  auto material = preStep->GetMaterial();
+  auto mpt = material->GetMaterialPropertiesTable();
+  if ( ! mpt ) return;
+
+  // No record for a source disabled in the volume
+  auto sources = PhotonSources::Instance();
+  auto volume = preStep->GetPhysicalVolume()->GetLogicalVolume();
+  auto scintillation
+    = activation.first
+      && sources->IsEnabled(PhotonSources::kScintillation, volume);
+  auto cerenkov
+    = activation.second
+      && sources->IsEnabled(PhotonSources::kCerenkov, volume);
+
+  EmissionRecord record;
+  record.start = preStep->GetPosition();
+  record.end = postStep->GetPosition();
+  record.startTime = preStep->GetGlobalTime();
+  record.startVelocity = preStep->GetVelocity();
+  record.endVelocity = postStep->GetVelocity();
+  record.material = material;
+  record.touchable = preStep->GetTouchableHandle();
+  record.parentID = track->GetTrackID();
+
+  if ( scintillation && step->GetTotalEnergyDeposit() > 0.
+       && mpt->ConstPropertyExists(kSCINTILLATIONYIELD) ) {
+    record.nofPhotons = fScintillation->GetNumPhotons();
+    if ( record.nofPhotons > 0 ) fRecords.push_back(record);
+  }
+
+  auto charge = track->GetDefinition()->GetPDGCharge();
+  auto rindex = mpt->GetProperty(kRINDEX);
+  if ( cerenkov && charge != 0. && rindex ) {
+    auto beta = (preStep->GetBeta() + postStep->GetBeta()) / 2.;
+    if ( fCerenkov->GetAverageNumberOfPhotons(charge, beta, material, rindex)
+         <= 0. ) return;
+
+    record.cerenkov = true;
+    record.betaInverse = 1. / beta;
+    record.meanPhotons1 = fCerenkov->GetAverageNumberOfPhotons(
+      charge, preStep->GetBeta(), material, rindex);
+    record.meanPhotons2 = fCerenkov->GetAverageNumberOfPhotons(
+      charge, postStep->GetBeta(), material, rindex);
+    record.nofPhotons = fCerenkov->GetNumPhotons();
+    if ( record.nofPhotons > 0 ) fRecords.push_back(record);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int LazyPhotons::Materialise()
+{
+  fBatch.clear();
+  while ( ! fRecords.empty() && G4int(fBatch.size()) < fBatchSize ) {
+    auto& record = fRecords.back();
+    auto nofPhotons
+      = std::min(record.nofPhotons, fBatchSize - G4int(fBatch.size()));
+    if ( record.cerenkov ) {
+      SampleCerenkov(record, nofPhotons);
+    }
+    else {
+      SampleScintillation(record, nofPhotons);
+    }
+    record.nofPhotons -= nofPhotons;
+    if ( record.nofPhotons == 0 ) fRecords.pop_back();
+  }
+
+  auto nofPhotons = G4int(fBatch.size());
+  if ( nofPhotons > 0 ) {
+    // Assigns the track IDs and classifies the tracks via the stacking action
+    G4EventManager::GetEventManager()->StackTracks(&fBatch);
+  }
+  return nofPhotons;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LazyPhotons::SampleScintillation(const EmissionRecord& record,
+                                      G4int nofPhotons)
+{
+  static const G4MaterialConstPropertyIndex kYield[3]
+    = { kSCINTILLATIONYIELD1, kSCINTILLATIONYIELD2, kSCINTILLATIONYIELD3 };
+  static const G4MaterialConstPropertyIndex kTimeConstant[3]
+    = { kSCINTILLATIONTIMECONSTANT1, kSCINTILLATIONTIMECONSTANT2,
+        kSCINTILLATIONTIMECONSTANT3 };
+  static const G4MaterialConstPropertyIndex kRiseTime[3]
+    = { kSCINTILLATIONRISETIME1, kSCINTILLATIONRISETIME2,
+        kSCINTILLATIONRISETIME3 };
+
+  // Components of the material, weighted by their relative yields
+  auto mpt = record.material->GetMaterialPropertiesTable();
+  auto index = record.material->GetIndex();
+  auto finiteRiseTime
+    = G4OpticalParameters::Instance()->GetScintFiniteRiseTime();
+  G4PhysicsTable* tables[3] = { fScintillation->GetIntegralTable1(),
+                                fScintillation->GetIntegralTable2(),
+                                fScintillation->GetIntegralTable3() };
+  const G4PhysicsVector* spectra[3] = { nullptr, nullptr, nullptr };
+  G4double weights[3] = { 0., 0., 0. };
+  G4double riseTimes[3] = { 0., 0., 0. };
+  G4double decayTimes[3] = { 0., 0., 0. };
+  G4double sumWeights = 0.;
+  auto last = 0;
+  for ( auto i = 0; i < 3; ++i ) {
+    if ( ! tables[i] || index >= tables[i]->size() ) continue;
+    spectra[i] = (*tables[i])(index);
+    if ( ! spectra[i] || spectra[i]->GetVectorLength() == 0 ) continue;
+    weights[i] = mpt->ConstPropertyExists(kYield[i])
+               ? mpt->GetConstProperty(kYield[i]) : ( i == 0 ? 1. : 0. );
+    if ( mpt->ConstPropertyExists(kTimeConstant[i]) ) {
+      decayTimes[i] = mpt->GetConstProperty(kTimeConstant[i]);
+    }
+    if ( finiteRiseTime && mpt->ConstPropertyExists(kRiseTime[i]) ) {
+      riseTimes[i] = mpt->GetConstProperty(kRiseTime[i]);
+    }
+    sumWeights += weights[i];
+    if ( weights[i] > 0. ) last = i;
+  }
+  if ( sumWeights <= 0. ) return;
+
+  auto segment = record.end - record.start;
+  auto meanVelocity = (record.startVelocity + record.endVelocity) / 2.;
+
+  for ( auto n = 0; n < nofPhotons; ++n ) {
+    auto i = 0;
+    auto pick = G4UniformRand() * sumWeights;
+    while ( i < last && pick >= weights[i] ) {
+      pick -= weights[i];
+      ++i;
+    }
+
+    // Energy from the integral of the emission spectrum
+    auto energy
+      = spectra[i]->GetEnergy(G4UniformRand() * spectra[i]->GetMaxValue());
+
+    // Isotropic direction, random linear polarisation
+    auto cost = 1. - 2. * G4UniformRand();
+    auto sint = std::sqrt((1. - cost) * (1. + cost));
+    auto phi = twopi * G4UniformRand();
+    G4ThreeVector direction(sint * std::cos(phi), sint * std::sin(phi), cost);
+    G4ThreeVector polarization(cost * std::cos(phi), cost * std::sin(phi),
+                               -sint);
+    auto perpendicular = direction.cross(polarization);
+    auto angle = twopi * G4UniformRand();
+    polarization = std::cos(angle) * polarization
+                 + std::sin(angle) * perpendicular;
+    polarization = polarization.unit();
+
+    // Uniform along the step, then the emission delay
+    auto fraction = G4UniformRand();
+    auto time = record.startTime
+              + SampleEmissionTime(riseTimes[i], decayTimes[i]);
+    if ( meanVelocity > 0. ) {
+      time += fraction * segment.mag() / meanVelocity;
+    }
+
+    fBatch.push_back(MakePhoton(record, fScintillation, energy, direction,
+      polarization, time, record.start + fraction * segment));
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void LazyPhotons::SampleCerenkov(const EmissionRecord& record,
+                                 G4int nofPhotons)
+{
+  auto rindex
+    = record.material->GetMaterialPropertiesTable()->GetProperty(kRINDEX);
+  auto minEnergy = rindex->Energy(0);
+  auto energyRange = rindex->GetMaxEnergy() - minEnergy;
+  auto maxCos = record.betaInverse / rindex->GetMaxValue();
+  auto maxSin2 = (1. - maxCos) * (1. + maxCos);
+
+  auto segment = record.end - record.start;
+  auto axis = segment.unit();
+  auto maxMean = std::max(record.meanPhotons1, record.meanPhotons2);
+
+  for ( auto n = 0; n < nofPhotons; ++n ) {
+    // Energy and opening angle by rejection on sin^2(theta)
+    G4double energy, cosTheta, sin2Theta;
+    do {
+      energy = minEnergy + G4UniformRand() * energyRange;
+      cosTheta = record.betaInverse / rindex->Value(energy);
+      sin2Theta = (1. - cosTheta) * (1. + cosTheta);
+    } while ( G4UniformRand() * maxSin2 > sin2Theta );
+
+    // On the cone around the step, polarised in the plane of the cone
+    auto phi = twopi * G4UniformRand();
+    auto sinTheta = std::sqrt(sin2Theta);
+    G4ThreeVector direction(sinTheta * std::cos(phi),
+                            sinTheta * std::sin(phi), cosTheta);
+    direction.rotateUz(axis);
+    G4ThreeVector polarization(cosTheta * std::cos(phi),
+                               cosTheta * std::sin(phi), -sinTheta);
+    polarization.rotateUz(axis);
+
+    // Along the step, following the yield variation with the velocity
+    G4double fraction;
+    do {
+      fraction = G4UniformRand();
+    } while ( G4UniformRand() * maxMean > record.meanPhotons1
+              - fraction * (record.meanPhotons1 - record.meanPhotons2) );
+
+    // Same velocity interpolation as G4Cerenkov
+    auto velocity = record.startVelocity
+      + fraction * (record.endVelocity - record.startVelocity) * 0.5;
+    auto time = record.startTime;
+    if ( velocity > 0. ) {
+      time += fraction * segment.mag() / velocity;
+    }
+
+    fBatch.push_back(MakePhoton(record, fCerenkov, energy, direction,
+      polarization, time, record.start + fraction * segment));
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
@@ -0,0 +1,122 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file OutputSchema.cc
+/// \brief Implementation of the histogram and ntuple layout of the B4c output
+
+#include "OutputSchema.hh"
+#include "PhotonCounters.hh"
+#include "PhotonTrackInfo.hh"
+
+#include "G4AnalysisManager.hh"
+
+namespace B4c
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const std::vector<H1Schema>& GetH1Schemas()
+{
+  static const std::vector<H1Schema> schemas = {
+    {"Counter", "Counter", 50, 0., 30000.}
+    //{"Egap", "Edep in gap", 100, 0., 100*MeV},
+    //{"Labs", "trackL in absorber", 100, 0., 1*m},
+    //{"Lgap", "trackL in gap", 100, 0., 50*cm}
+  };
+  return schemas;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const std::vector<NtupleSchema>& GetNtupleSchemas()
+{
+  static const std::vector<NtupleSchema> schemas = [] {
+    std::vector<NtupleSchema> result;
+
+    NtupleSchema photons{"B4", "Photons Detected",
+      {{"Event", 'D'}, {"Wavelength", 'D'}, {"Time", 'D'}}};
+    for ( G4int i = 0; i < PhotonTrackInfo::kNofPaths; ++i ) {
+      photons.columns.push_back(
+        {PhotonTrackInfo::GetName(PhotonTrackInfo::Path(i)), 'D'});
+    }
+    photons.columns.push_back({"Creator", 'I'});
+    result.push_back(photons);
+
+    result.push_back({"Event", "Event", {{"Counter", 'D'}}});
+
+    result.push_back({"PMT", "PMT digitisation summary",
+      {{"Event", 'I'}, {"NPE", 'I'}, {"Crossing", 'D'}, {"Peak", 'I'},
+       {"Charge", 'D'}}});
+
+    NtupleSchema budget{"Budget", "Photon budget per event", {{"Event", 'I'}}};
+    for ( G4int i = 0; i < PhotonCounters::kNofCounters; ++i ) {
+      budget.columns.push_back(
+        {PhotonCounters::GetName(PhotonCounters::Counter(i)), 'I'});
+    }
+    result.push_back(budget);
+
+    result.push_back({"Timing", "Event wall time and stack depth",
+      {{"Event", 'I'}, {"WallTime", 'D'}, {"PeakStack", 'I'},
+       {"Photons", 'I'}}});
+
+    return result;
+  }();
+  return schemas;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CreateHistograms()
+{
+  auto analysisManager = G4AnalysisManager::Instance();
+  for ( const auto& schema : GetH1Schemas() ) {
+    analysisManager->CreateH1(schema.name, schema.title,
+                              schema.nbins, schema.xmin, schema.xmax);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CreateNtuples()
+{
+  auto analysisManager = G4AnalysisManager::Instance();
+  for ( const auto& schema : GetNtupleSchemas() ) {
+    auto ntupleId = analysisManager->CreateNtuple(schema.name, schema.title);
+    for ( const auto& column : schema.columns ) {
+      if ( column.type == 'I' ) {
+        analysisManager->CreateNtupleIColumn(column.name);
+      }
+      else {
+        analysisManager->CreateNtupleDColumn(column.name);
+      }
+    }
+    analysisManager->FinishNtuple(ntupleId);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
@@ -0,0 +1,307 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file PMTDigitizer.cc
+/// \brief Implementation of the B4c::PMTDigitizer class
+
+#include "PMTDigitizer.hh"
+#include "Checkpoint.hh"
+#include "CalorimeterSD.hh"
+#include "PMTDigi.hh"
+#include "PhotonHit.hh"
+
+#include "G4AnalysisManager.hh"
+#include "G4DigiManager.hh"
+#include "G4Event.hh"
+#include "G4GenericMessenger.hh"
+#include "G4RunManager.hh"
+#include "G4SDManager.hh"
+#include "G4Threading.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace B4c
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PMTDigitizer::PMTDigitizer(const G4String& name)
+ : G4VDigitizerModule(name)
+{
+  collectionName.push_back("PMTDigitsCollection");
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PMTDigitizer::~PMTDigitizer()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PMTDigitizer::BuildTemplate()
+{
+  fNofSamples = std::max(1, G4int(std::lround(fWindowLength/fSamplePeriod)));
+
+  // Pulse shape: exp(-t/fall) - exp(-t/rise), cut when it has decayed
+  auto shape = [this](G4double t) {
+    if ( t < 0. ) return 0.;
+    if ( fSpeRiseTime == fSpeFallTime ) {
+      return t/fSpeFallTime * std::exp(-t/fSpeFallTime);
+    }
+    return std::exp(-t/fSpeFallTime) - std::exp(-t/fSpeRiseTime);
+  };
+  auto tauMax = std::max(fSpeRiseTime, fSpeFallTime);
+  auto duration = 10.*tauMax;
+  fNofTaps = std::max(1, G4int(std::ceil(duration/fSamplePeriod)) + 1);
+
+  // Normalise the maximum to the single-photoelectron amplitude
+  G4double maximum = 0.;
+  for ( G4int i = 0; i <= 1000; ++i ) {
+    maximum = std::max(maximum, shape(i*duration/1000.));
+  }
+  auto norm = ( maximum > 0. ) ? 1./maximum : 0.;
+
+  // One row per sub-sample phase of the photon arrival
+  fTemplate.assign(kOversampling*fNofTaps, 0.f);
+  for ( G4int phase = 0; phase < kOversampling; ++phase ) {
+    auto offset = (phase + 0.5)/kOversampling;
+    for ( G4int k = 0; k < fNofTaps; ++k ) {
+      fTemplate[phase*fNofTaps + k] =
+        G4float(norm*shape((k - offset)*fSamplePeriod));
+    }
+  }
+
+  fAccumulator.assign(fNofSamples, 0.f);
+  fTrace.assign(fNofSamples, 0);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PMTDigitizer::AccumulatePulse(G4double position, G4float amplitude)
+{
+  auto first = G4int(position);
+  auto phase = std::min(G4int((position - first)*kOversampling),
+                        kOversampling - 1);
+  auto n = std::min(fNofTaps, fNofSamples - first);
+
+  const G4float* tpl = fTemplate.data() + phase*fNofTaps;
+  G4float* out = fAccumulator.data() + first;
+  for ( G4int k = 0; k < n; ++k ) {
+    out[k] += amplitude*tpl[k];
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PMTDigitizer::Digitize()
+{
+  if ( ! fEnabled ) return;
+  if ( fAccumulator.empty() ) BuildTemplate();
+
+  // The photon hits are kept by the PMT sensitive detector
+  if ( ! fSD ) {
+    auto sdManager = G4SDManager::GetSDMpointer();
+    fSD = static_cast<const CalorimeterSD*>(
+      sdManager->FindSensitiveDetector("AbsorberSD", false));
+    if ( ! fSD ) {
+      G4ExceptionDescription msg;
+      msg << "Cannot access sensitive detector AbsorberSD";
+      G4Exception("PMTDigitizer::Digitize()",
+        "MyCode0005", FatalException, msg);
+    }
+  }
+
+  // Accumulate one template per photoelectron
+  std::fill(fAccumulator.begin(), fAccumulator.end(), 0.f);
+  G4int nofPhotoElectrons = 0;
+  for ( const auto& hit : fSD->GetPhotonHits() ) {
+    auto time = hit.GetTime() - fWindowStart;
+    if ( fTransitTimeSpread > 0. ) {
+      time += G4RandGauss::shoot(0., fTransitTimeSpread);
+    }
+    auto position = time/fSamplePeriod;
+    if ( position < 0. || position >= fNofSamples ) continue;
+
+    auto amplitude = fSpeAmplitude;
+    if ( fSpeResolution > 0. ) {
+      amplitude *= std::max(0., G4RandGauss::shoot(1., fSpeResolution));
+    }
+    AccumulatePulse(position, G4float(amplitude));
+    ++nofPhotoElectrons;
+  }
+
+  // Quantise to 16 bits and extract the threshold-crossing summary
+  auto digi = new PMTDigi;
+  G4int peak = 0;
+  G4double charge = 0.;
+  G4double crossing = -1.;
+  G4int previous = 0;
+  for ( G4int i = 0; i < fNofSamples; ++i ) {
+    auto value = std::lround(fAccumulator[i]);
+    value = std::clamp<long>(value, std::numeric_limits<G4short>::min(),
+                                    std::numeric_limits<G4short>::max());
+    fTrace[i] = G4short(value);
+    peak = std::max(peak, G4int(value));
+    charge += value;
+    if ( crossing < 0. && value >= fThreshold ) {
+      auto fraction = ( i > 0 ) ? (fThreshold - previous)/(value - previous)
+                                : 1.;
+      crossing = fWindowStart + (i - 1 + fraction)*fSamplePeriod;
+    }
+    previous = G4int(value);
+  }
+  digi->SetNofPhotoElectrons(nofPhotoElectrons);
+  digi->SetCrossingTime(crossing);
+  digi->SetPeak(peak);
+  digi->SetCharge(charge);
+  if ( fOutputMode == "trace" ) {
+    digi->GetTrace() = fTrace;
+  }
+
+  auto digitsCollection = new PMTDigitsCollection(GetName(), collectionName[0]);
+  digitsCollection->insert(digi);
+  StoreDigiCollection(digitsCollection);
+
+  // Write the summary and, on request, the trace
+  auto eventID = G4RunManager::GetRunManager()->GetCurrentEvent()->GetEventID()
+               + Checkpoint::GetEventOffset();
+  auto analysisManager = G4AnalysisManager::Instance();
+  analysisManager->FillNtupleIColumn(2, 0, eventID);
+  analysisManager->FillNtupleIColumn(2, 1, nofPhotoElectrons);
+  analysisManager->FillNtupleDColumn(2, 2, crossing);
+  analysisManager->FillNtupleIColumn(2, 3, peak);
+  analysisManager->FillNtupleDColumn(2, 4, charge);
+  analysisManager->AddNtupleRow(2);
+
+  if ( fOutputMode == "trace" ) {
+    WriteTrace(eventID, fTrace);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PMTDigitizer::WriteTrace(G4int eventID, const std::vector<G4short>& trace)
+{
+  if ( ! fTraceFile.is_open() ) {
+    G4String fileName = "B4_pmt";
+    auto threadID = G4Threading::G4GetThreadId();
+    if ( threadID >= 0 ) fileName += "_t" + std::to_string(threadID);
+    fileName += ".dat";
+    fTraceFile.open(fileName, std::ios::binary | std::ios::trunc);
+
+    std::int32_t version = 1;
+    std::int32_t nofSamples = fNofSamples;
+    float period = G4float(fSamplePeriod/ns);
+    fTraceFile.write("B4WF", 4);
+    fTraceFile.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    fTraceFile.write(reinterpret_cast<const char*>(&nofSamples),
+                     sizeof(nofSamples));
+    fTraceFile.write(reinterpret_cast<const char*>(&period), sizeof(period));
+  }
+
+  std::int32_t id = eventID;
+  fTraceFile.write(reinterpret_cast<const char*>(&id), sizeof(id));
+  fTraceFile.write(reinterpret_cast<const char*>(trace.data()),
+                   trace.size()*sizeof(G4short));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PMTDigitizer::BeginOfRun()
+{
+  // Parameters may have changed between runs
+  BuildTemplate();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PMTDigitizer::EndOfRun()
+{
+  if ( fTraceFile.is_open() ) fTraceFile.close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PMTDigitizer::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/B4/digi/",
+                                      "PMT waveform digitisation control");
+
+  auto& enableCmd = fMessenger->DeclareProperty("enable", fEnabled,
+    "Digitise the PMT photon hits at the end of each event.");
+  enableCmd.SetParameterName("flag", true);
+  enableCmd.SetDefaultValue("true");
+
+  auto& modeCmd = fMessenger->DeclareProperty("outputMode", fOutputMode,
+    "summary: threshold-crossing summary only; trace: also 16-bit samples.");
+  modeCmd.SetCandidates("summary trace");
+
+  auto& periodCmd = fMessenger->DeclarePropertyWithUnit("samplePeriod", "ns",
+    fSamplePeriod, "Sampling period (inverse of the sampling rate).");
+  periodCmd.SetParameterName("period", false);
+  periodCmd.SetRange("period>0.");
+
+  fMessenger->DeclarePropertyWithUnit("windowStart", "ns", fWindowStart,
+    "Global time of the first sample.");
+
+  auto& lengthCmd = fMessenger->DeclarePropertyWithUnit("windowLength", "ns",
+    fWindowLength, "Length of the digitised trace.");
+  lengthCmd.SetParameterName("length", false);
+  lengthCmd.SetRange("length>0.");
+
+  fMessenger->DeclarePropertyWithUnit("transitTimeSpread", "ns",
+    fTransitTimeSpread, "Gaussian sigma of the PMT transit time spread.");
+
+  fMessenger->DeclareProperty("speAmplitude", fSpeAmplitude,
+    "Single-photoelectron pulse maximum in ADC counts.");
+
+  fMessenger->DeclareProperty("speResolution", fSpeResolution,
+    "Relative gaussian spread of the single-photoelectron gain.");
+
+  auto& riseCmd = fMessenger->DeclarePropertyWithUnit("speRiseTime", "ns",
+    fSpeRiseTime, "Rise time constant of the single-photoelectron template.");
+  riseCmd.SetParameterName("rise", false);
+  riseCmd.SetRange("rise>0.");
+
+  auto& fallCmd = fMessenger->DeclarePropertyWithUnit("speFallTime", "ns",
+    fSpeFallTime, "Fall time constant of the single-photoelectron template.");
+  fallCmd.SetParameterName("fall", false);
+  fallCmd.SetRange("fall>0.");
+
+  fMessenger->DeclareProperty("threshold", fThreshold,
+    "Threshold in ADC counts for the crossing time.");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
@@ -0,0 +1,405 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file PerfCounters.cc
+/// \brief Implementation of the B4c::PerfCounters class
+
+#include "PerfCounters.hh"
+
+#include "G4AutoLock.hh"
+#include "G4GenericMessenger.hh"
+#include "G4StateManager.hh"
+#include "G4Threading.hh"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace B4c
+{
+
+namespace
+{
+  // Report merged from all threads, keyed by thread ID (-1 for the master)
+  using PhaseTotals = std::array<std::array<G4double, 1 +
+    PerfCounters::kNofCounters>, PerfCounters::kNofPhases>; // calls, counts
+
+  G4Mutex reportMutex = G4MUTEX_INITIALIZER;
+  std::map<G4int, PhaseTotals> report;
+  std::array<G4bool, PerfCounters::kNofCounters> available;
+  G4bool availableSet = false;
+
+  G4String GetThreadName(G4int threadID)
+  {
+    return ( threadID < 0 ) ? "master" : std::to_string(threadID);
+  }
+}
+
+G4ThreadLocal PerfCounters* PerfCounters::fgInstance = nullptr;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PerfCounters* PerfCounters::Instance()
+{
+  if ( ! fgInstance ) {
+    fgInstance = new PerfCounters();
+  }
+  return fgInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const char* PerfCounters::GetName(Phase phase)
+{
+  static const char* names[kNofPhases] = {
+    "initialisation", "generate_primaries", "tracking", "process_hits",
+    "end_of_event", "output"
+  };
+  return names[phase];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const char* PerfCounters::GetName(Counter counter)
+{
+  static const char* names[kNofCounters] = {
+    "cycles", "instructions", "cache_misses", "branch_misses"
+  };
+  return names[counter];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PerfCounters::PerfCounters()
+{
+  fDescriptors.fill(-1);
+  fSlots.fill(-1);
+
+  fMessenger = new G4GenericMessenger(this, "/B4/perf/",
+                                      "Hardware performance counters");
+
+  auto& enableCmd = fMessenger->DeclareMethod("enable",
+    &PerfCounters::SetEnabled,
+    "Count cycles, instructions, cache and branch misses per run phase; "
+    "enable before /run/initialize to include the initialisation.");
+  enableCmd.SetParameterName("flag", true);
+  enableCmd.SetDefaultValue("true");
+
+  auto& jsonCmd = fMessenger->DeclareProperty("json", fJsonPrefix,
+    "Also write the counts to <prefix>_run<N>.json (none if empty).");
+  jsonCmd.SetParameterName("prefix", false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PerfCounters::~PerfCounters()
+{
+  Close();
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PerfCounters::SetEnabled(G4bool enabled)
+{
+  if ( ! enabled ) {
+    Close();
+    return;
+  }
+  if ( IsActive() ) return;
+
+  Open();
+  auto state = G4StateManager::GetStateManager()->GetCurrentState();
+  if ( IsActive() && state == G4State_PreInit ) {
+    fInitialising = true;
+    Start(kInitialisation);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PerfCounters::Open()
+{
+#ifdef __linux__
+  static const std::uint64_t configs[kNofCounters] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+  };
+
+  // One group led by the cycles counter, read at once, on this thread only
+  fNofOpen = 0;
+  for ( G4int i = 0; i < kNofCounters; ++i ) {
+    perf_event_attr attributes;
+    std::memset(&attributes, 0, sizeof(attributes));
+    attributes.size = sizeof(attributes);
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.config = configs[i];
+    attributes.disabled = ( i == kCycles ) ? 1 : 0;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    attributes.read_format = PERF_FORMAT_GROUP
+                           | PERF_FORMAT_TOTAL_TIME_ENABLED
+                           | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    auto descriptor = G4int(syscall(SYS_perf_event_open, &attributes, 0, -1,
+                                    fDescriptors[kCycles], 0));
+    if ( descriptor < 0 ) {
+      G4ExceptionDescription msg;
+      msg << "Cannot open the " << GetName(Counter(i)) << " counter: "
+          << std::strerror(errno)
+          << " (see /proc/sys/kernel/perf_event_paranoid).";
+      if ( i == kCycles ) msg << " No performance counters.";
+      G4Exception("PerfCounters::Open()", "MyCode0013", JustWarning, msg);
+      if ( i == kCycles ) return;
+      continue;
+    }
+    fDescriptors[i] = descriptor;
+    fSlots[i] = fNofOpen++;
+  }
+
+  ioctl(fDescriptors[kCycles], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(fDescriptors[kCycles], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  fGroup = fDescriptors[kCycles];
+#else
+  G4Exception("PerfCounters::Open()", "MyCode0013", JustWarning,
+              "Hardware performance counters need Linux perf_event_open.");
+#endif
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PerfCounters::Close()
+{
+#ifdef __linux__
+  for ( auto& descriptor : fDescriptors ) {
+    if ( descriptor >= 0 ) close(descriptor);
+    descriptor = -1;
+  }
+#endif
+  fSlots.fill(-1);
+  fNofOpen = 0;
+  fGroup = -1;
+  fInitialising = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PerfCounters::Read(Sample& sample) const
+{
+#ifdef __linux__
+  // nr, time enabled, time running, then the values in group order
+  std::uint64_t buffer[3 + kNofCounters];
+  if ( read(fGroup, buffer, sizeof(buffer)) < 0 ) return;
+  sample.enabled = buffer[1];
+  sample.running = buffer[2];
+  for ( G4int i = 0; i < kNofCounters; ++i ) {
+    if ( fSlots[i] >= 0 ) sample.values[i] = buffer[3 + fSlots[i]];
+  }
+#else
+  (void)sample;
+#endif
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PerfCounters::Accumulate(Phase phase)
+{
+  Sample now;
+  Read(now);
+  const auto& start = fStart[phase];
+
+  // Extrapolate when the counters were multiplexed during the phase
+  auto running = now.running - start.running;
+  auto scale = ( running > 0 )
+             ? G4double(now.enabled - start.enabled) / running : 1.;
+
+  auto& totals = fTotals[phase];
+  ++totals.calls;
+  for ( G4int i = 0; i < kNofCounters; ++i ) {
+    totals.values[i] += (now.values[i] - start.values[i]) * scale;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PerfCounters::BeginOfRun()
+{
+  if ( fInitialising ) {
+    Stop(kInitialisation);
+    fInitialising = false;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PerfCounters::EndOfRun(G4bool isMaster, G4int runID)
+{
+  G4AutoLock lock(&reportMutex);
+
+  if ( IsActive() ) {
+    auto& merged = report[G4Threading::G4GetThreadId()];
+    for ( G4int p = 0; p < kNofPhases; ++p ) {
+      merged[p][0] += fTotals[p].calls;
+      for ( G4int i = 0; i < kNofCounters; ++i ) {
+        merged[p][1+i] += fTotals[p].values[i];
+      }
+      fTotals[p] = Totals();
+    }
+    for ( G4int i = 0; i < kNofCounters; ++i ) {
+      available[i] = ( availableSet ? available[i] : true )
+                     && fSlots[i] >= 0;
+    }
+    availableSet = true;
+  }
+
+  if ( ! isMaster || report.empty() ) return;
+
+  PhaseTotals total = {};
+  for ( const auto& thread : report ) {
+    for ( G4int p = 0; p < kNofPhases; ++p ) {
+      for ( std::size_t i = 0; i < total[p].size(); ++i ) {
+        total[p][i] += thread.second[p][i];
+      }
+    }
+  }
+
+  // Rates per phase: instructions per cycle, misses per 1000 instructions
+  auto ipc = [](const std::array<G4double, 1 + kNofCounters>& counts) {
+    return counts[1+kCycles] > 0. ? counts[1+kInstructions]
+                                    / counts[1+kCycles] : 0.;
+  };
+  auto perKilo = [](const std::array<G4double, 1 + kNofCounters>& counts,
+                    Counter counter) {
+    return counts[1+kInstructions] > 0. ? 1000.*counts[1+counter]
+                                          / counts[1+kInstructions] : 0.;
+  };
+
+  G4cout
+    << G4endl
+    << "------------------------ Performance counters ------------------------"
+    << G4endl
+    << std::left << " " << std::setw(19) << "Phase" << std::right
+    << std::setw(11) << "Calls" << std::setw(9) << "Gcycles"
+    << std::setw(9) << "Ginstr" << std::setw(6) << "IPC"
+    << std::setw(8) << "CM/ki" << std::setw(8) << "BM/ki" << G4endl
+    << std::fixed;
+  for ( G4int p = 0; p < kNofPhases; ++p ) {
+    const auto& counts = total[p];
+    if ( counts[0] == 0. ) continue;
+    G4cout
+      << std::left << " " << std::setw(19) << GetName(Phase(p)) << std::right
+      << std::setw(11) << std::setprecision(0) << counts[0]
+      << std::setw(9) << std::setprecision(3) << 1.e-9*counts[1+kCycles]
+      << std::setw(9) << 1.e-9*counts[1+kInstructions]
+      << std::setw(6) << std::setprecision(2) << ipc(counts)
+      << std::setw(8) << perKilo(counts, kCacheMisses)
+      << std::setw(8) << perKilo(counts, kBranchMisses) << G4endl;
+  }
+  G4cout << " Tracking per thread:" << G4endl;
+  for ( const auto& thread : report ) {
+    const auto& counts = thread.second[kTracking];
+    if ( counts[0] == 0. ) continue;
+    G4cout
+      << "   " << std::left << std::setw(17)
+      << "thread " + GetThreadName(thread.first) << std::right
+      << std::setw(11) << std::setprecision(0) << counts[0]
+      << std::setw(9) << std::setprecision(3) << 1.e-9*counts[1+kCycles]
+      << std::setw(9) << 1.e-9*counts[1+kInstructions]
+      << std::setw(6) << std::setprecision(2) << ipc(counts)
+      << std::setw(8) << perKilo(counts, kCacheMisses)
+      << std::setw(8) << perKilo(counts, kBranchMisses) << G4endl;
+  }
+  G4cout << " Summed over threads; CM/BM/ki: cache/branch misses per 1000"
+         << " instructions" << G4endl;
+  for ( G4int i = 0; i < kNofCounters; ++i ) {
+    if ( ! available[i] ) {
+      G4cout << " Missing counter: " << GetName(Counter(i)) << G4endl;
+    }
+  }
+  G4cout
+    << "----------------------------------------------------------------------"
+    << G4endl;
+  G4cout.unsetf(std::ios::fixed);
+  G4cout << std::setprecision(6);
+
+  // JSON, per thread and summed
+  if ( ! fJsonPrefix.empty() ) {
+    auto fileName = fJsonPrefix + "_run" + std::to_string(runID) + ".json";
+    std::ofstream json(fileName);
+    auto writePhases = [&json](const PhaseTotals& totals) {
+      json << "{";
+      for ( G4int p = 0; p < kNofPhases; ++p ) {
+        json << ( p ? ", " : "" ) << "\"" << GetName(Phase(p))
+             << "\": {\"calls\": " << std::uint64_t(totals[p][0]);
+        for ( G4int i = 0; i < kNofCounters; ++i ) {
+          if ( ! available[i] ) continue;
+          json << ", \"" << GetName(Counter(i)) << "\": "
+               << std::uint64_t(totals[p][1+i]);
+        }
+        json << "}";
+      }
+      json << "}";
+    };
+    json << "{\n  \"run\": " << runID << ",\n  \"missing\": [";
+    G4bool first = true;
+    for ( G4int i = 0; i < kNofCounters; ++i ) {
+      if ( available[i] ) continue;
+      json << ( first ? "" : ", " ) << "\"" << GetName(Counter(i)) << "\"";
+      first = false;
+    }
+    json << "],\n  \"threads\": {";
+    first = true;
+    for ( const auto& thread : report ) {
+      json << ( first ? "" : "," ) << "\n    \"" << GetThreadName(thread.first)
+           << "\": ";
+      writePhases(thread.second);
+      first = false;
+    }
+    json << "\n  },\n  \"total\": ";
+    writePhases(total);
+    json << "\n}\n";
+    if ( ! json ) {
+      G4ExceptionDescription msg;
+      msg << "Cannot write " << fileName;
+      G4Exception("PerfCounters::EndOfRun()", "MyCode0013", JustWarning, msg);
+    }
+  }
+
+  report.clear();
+  availableSet = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
@@ -0,0 +1,162 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file Photocathode.cc
+/// \brief Implementation of the B4c::Photocathode class
+
+#include "Photocathode.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4PhysicalConstants.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace B4c
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+Photocathode::Photocathode()
+{
+  // Typical bialkali quantum efficiency, in increasing photon energy
+  // (650 nm down to 300 nm)
+  G4double wavelength[15] = {650., 625., 600., 575., 550., 525., 500., 475.,
+                             450., 425., 400., 375., 350., 325., 300.};
+  G4double qe[15] = {0.01, 0.02, 0.04, 0.07, 0.10, 0.14, 0.18, 0.22,
+                     0.25, 0.27, 0.28, 0.28, 0.27, 0.24, 0.18};
+
+  fQE = new G4MaterialPropertyVector();
+  for ( G4int i = 0; i < 15; ++i ) {
+    fQE->InsertValues(h_Planck*c_light/(wavelength[i]*nm), qe[i]);
+  }
+
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+Photocathode::~Photocathode()
+{
+  delete fMessenger;
+  delete fQE;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double Photocathode::GetQuantumEfficiency(G4double photonEnergy) const
+{
+  // Value() clamps to the end points outside the tabulated range
+  return std::min(1., fQEScale*fQE->Value(photonEnergy));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+Photocathode::Stage Photocathode::Sample(G4double photonEnergy) const
+{
+  if ( ! fEnabled ) return kDetected;
+
+  if ( G4UniformRand() >= GetQuantumEfficiency(photonEnergy) ) {
+    return kFailedQE;
+  }
+  if ( G4UniformRand() >= fCollectionEfficiency ) {
+    return kFailedCE;
+  }
+  return kDetected;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Photocathode::ReadQEFile(const G4String& fileName)
+{
+  std::ifstream input(fileName);
+  if ( ! input ) {
+    G4ExceptionDescription msg;
+    msg << "Cannot open QE file " << fileName;
+    G4Exception("Photocathode::ReadQEFile()",
+      "MyCode0006", JustWarning, msg);
+    return;
+  }
+
+  // Two columns: wavelength in nm, quantum efficiency in [0,1]
+  std::map<G4double, G4double> points;
+  std::string line;
+  while ( std::getline(input, line) ) {
+    if ( line.empty() || line[0] == '#' ) continue;
+    std::istringstream columns(line);
+    G4double wavelength = 0., qe = 0.;
+    if ( columns >> wavelength >> qe && wavelength > 0. ) {
+      points[h_Planck*c_light/(wavelength*nm)] = qe;
+    }
+  }
+  if ( points.size() < 2 ) {
+    G4ExceptionDescription msg;
+    msg << "QE file " << fileName << " has less than two points, ignored";
+    G4Exception("Photocathode::ReadQEFile()",
+      "MyCode0006", JustWarning, msg);
+    return;
+  }
+
+  delete fQE;
+  fQE = new G4MaterialPropertyVector();
+  for ( const auto& point : points ) {
+    fQE->InsertValues(point.first, point.second);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Photocathode::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/B4/pmt/",
+                                      "PMT photocathode control");
+
+  auto& enableCmd = fMessenger->DeclareProperty("enable", fEnabled,
+    "Apply quantum and collection efficiencies to photons reaching the PMT.");
+  enableCmd.SetParameterName("flag", true);
+  enableCmd.SetDefaultValue("true");
+
+  auto& scaleCmd = fMessenger->DeclareProperty("qeScale", fQEScale,
+    "Scale factor applied to the quantum efficiency spectrum.");
+  scaleCmd.SetParameterName("scale", false);
+  scaleCmd.SetRange("scale>=0.");
+
+  auto& ceCmd = fMessenger->DeclareProperty("collectionEfficiency",
+    fCollectionEfficiency, "Photoelectron collection efficiency.");
+  ceCmd.SetParameterName("efficiency", false);
+  ceCmd.SetRange("efficiency>=0. && efficiency<=1.");
+
+  fMessenger->DeclareMethod("qeFile", &Photocathode::ReadQEFile,
+    "Read the QE spectrum from a file of (wavelength [nm], QE) lines.");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
@@ -0,0 +1,163 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file PhotonCodec.cc
+/// \brief Implementation of the compact photon encoding of the B4c output
+
+#include "PhotonCodec.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace B4c
+{
+
+namespace {
+
+  void PutVarint(std::string& buffer, std::uint64_t value)
+  {
+    while ( value >= 0x80 ) {
+      buffer.push_back(char((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    buffer.push_back(char(value));
+  }
+
+  // Nearest step of value, clamped to [0, max]
+  std::uint64_t Quantise(G4double value, G4double step, std::uint64_t max)
+  {
+    auto code = std::llround(value / step);
+    if ( code < 0 ) return 0;
+    return std::min(std::uint64_t(code), max);
+  }
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const std::string& PhotonCodec::GetMagic()
+{
+  static const std::string magic("B4P\x01", 4);
+  return magic;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhotonCodec::EncodeEvent(G4int eventID,
+                              std::vector<CompactPhoton>& photons,
+                              std::string& buffer)
+{
+  std::sort(photons.begin(), photons.end(),
+    [](const CompactPhoton& a, const CompactPhoton& b) {
+      return a.time < b.time; });
+
+  PutVarint(buffer, std::uint64_t(std::max(eventID, 0)));
+  PutVarint(buffer, photons.size());
+
+  std::uint64_t previous = 0;
+  for ( const auto& photon : photons ) {
+    auto wavelength = Quantise(photon.wavelength - kWavelengthOffset,
+                               kWavelengthStep, 0xffff);
+    buffer.push_back(char(wavelength & 0xff));
+    buffer.push_back(char(wavelength >> 8));
+
+    // Sorted times give sorted codes: the differences are not negative
+    auto time = Quantise(photon.time, kTimeStep, 0xffffffff);
+    PutVarint(buffer, time - previous);
+    previous = time;
+
+    buffer.push_back(char(std::uint8_t(photon.creator)));
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PhotonDecoder::Open(const G4String& fileName)
+{
+  fFile.open(fileName, std::ios::binary);
+  fCorrupted = false;
+  std::string magic(PhotonCodec::GetMagic().size(), '\0');
+  if ( ! fFile.read(&magic[0], magic.size()) ) return false;
+  return magic == PhotonCodec::GetMagic();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PhotonDecoder::ReadVarint(std::uint64_t& value)
+{
+  value = 0;
+  for ( G4int shift = 0; shift < 64; shift += 7 ) {
+    auto byte = fFile.get();
+    if ( byte == std::char_traits<char>::eof() ) return false;
+    value |= std::uint64_t(byte & 0x7f) << shift;
+    if ( ! ( byte & 0x80 ) ) return true;
+  }
+  return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PhotonDecoder::ReadEvent(G4int& eventID,
+                                std::vector<CompactPhoton>& photons)
+{
+  photons.clear();
+  std::uint64_t id = 0, size = 0;
+  if ( ! ReadVarint(id) ) return false;  // end of file
+  if ( ! ReadVarint(size) ) {
+    fCorrupted = true;
+    return false;
+  }
+  eventID = G4int(id);
+
+  // No up-front allocation from a possibly corrupted size
+  std::uint64_t time = 0;
+  for ( std::uint64_t i = 0; i < size; ++i ) {
+    unsigned char bytes[2];
+    std::uint64_t delta = 0;
+    if ( ! fFile.read(reinterpret_cast<char*>(bytes), 2)
+         || ! ReadVarint(delta) ) {
+      fCorrupted = true;
+      return false;
+    }
+    auto creator = fFile.get();
+    if ( creator == std::char_traits<char>::eof() ) {
+      fCorrupted = true;
+      return false;
+    }
+    time += delta;
+    CompactPhoton photon;
+    photon.wavelength = PhotonCodec::kWavelengthOffset
+      + (bytes[0] | (bytes[1] << 8)) * PhotonCodec::kWavelengthStep;
+    photon.time = G4double(time) * PhotonCodec::kTimeStep;
+    photon.creator = creator;
+    photons.push_back(photon);
+  }
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
@@ -0,0 +1,211 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file PhotonCounters.cc
+/// \brief Implementation of the B4c::PhotonCounters class
+
+#include "PhotonCounters.hh"
+
+#include "G4AccumulableManager.hh"
+#include "G4EmProcessSubType.hh"
+#include "G4GenericMessenger.hh"
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+
+#include <iomanip>
+
+namespace B4c
+{
+
+G4ThreadLocal PhotonCounters* PhotonCounters::fgInstance = nullptr;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PhotonCounters* PhotonCounters::Instance()
+{
+  if ( ! fgInstance ) {
+    fgInstance = new PhotonCounters();
+  }
+  return fgInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PhotonCounters::PhotonCounters()
+{
+  auto accumulableManager = G4AccumulableManager::Instance();
+  for ( auto& counter : fRun ) {
+    accumulableManager->RegisterAccumulable(counter);
+  }
+
+  fMessenger = new G4GenericMessenger(this, "/B4/budget/",
+                                      "Optical photon budget control");
+  auto& ntupleCmd = fMessenger->DeclareProperty("writeNtuple", fWriteNtuple,
+    "Write the per-event photon budget to the Budget ntuple.");
+  ntupleCmd.SetParameterName("flag", true);
+  ntupleCmd.SetDefaultValue("true");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PhotonCounters::~PhotonCounters()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const char* PhotonCounters::GetName(Counter counter)
+{
+  static const char* names[kNofCounters] = {
+    "ScintQD", "ScintBottle", "ScintOther",
+    "CerenkovQD", "CerenkovBottle", "CerenkovOther",
+    "CreatedOther",
+    "AbsorbedQD", "AbsorbedBottle", "AbsorbedPMT", "AbsorbedOther",
+    "AbsorbedWall",
+    "Escaped", "BelowCutoff", "Culled", "Suppressed",
+    "ReachedPMT", "PassedQE", "Detected",
+    "Recorded"
+  };
+  return names[counter];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PhotonCounters::Location PhotonCounters::Locate(const G4LogicalVolume* volume)
+{
+  if ( ! fQDVolume ) {
+    auto store = G4LogicalVolumeStore::GetInstance();
+    fQDVolume = store->GetVolume("QD", false);
+    fBottleVolume = store->GetVolume("Bottle", false);
+    fPMTVolume = store->GetVolume("AbsoLV", false);
+  }
+
+  if ( volume == fQDVolume ) return kQD;
+  if ( volume == fBottleVolume ) return kBottle;
+  if ( volume == fPMTVolume ) return kPMT;
+  return kElsewhere;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhotonCounters::AddCreated(const G4Track* track)
+{
+  auto process = track->GetCreatorProcess();
+  auto subType = process ? process->GetProcessSubType() : -1;
+  if ( subType != fScintillation && subType != fCerenkov ) {
+    Add(kCreatedOther);
+    return;
+  }
+
+  auto location = Locate(track->GetVolume()->GetLogicalVolume());
+  auto first = ( subType == fScintillation ) ? kCreatedScintQD
+                                             : kCreatedCerenkovQD;
+  if ( location == kQD ) Add(first);
+  else if ( location == kBottle ) Add(Counter(first + 1));
+  else Add(Counter(first + 2));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhotonCounters::AddAbsorbed(const G4LogicalVolume* volume)
+{
+  switch ( Locate(volume) ) {
+    case kQD:     Add(kAbsorbedQD); break;
+    case kBottle: Add(kAbsorbedBottle); break;
+    case kPMT:    Add(kAbsorbedPMT); break;
+    default:      Add(kAbsorbedOther); break;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhotonCounters::Print() const
+{
+  std::array<G4long, kNofCounters> values;
+  for ( G4int i = 0; i < kNofCounters; ++i ) {
+    values[i] = fRun[i].GetValue();
+  }
+  Print(values);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhotonCounters::Print(const std::array<G4long, kNofCounters>& values)
+{
+  G4long created = 0;
+  for ( G4int i = kCreatedScintQD; i <= kCreatedOther; ++i ) {
+    created += values[i];
+  }
+  auto percent = [created](G4long n) {
+    return ( created > 0 ) ? 100.*n/created : 0.;
+  };
+  auto line = [&](const char* label, Counter counter) {
+    auto value = values[counter];
+    G4cout << " " << std::left << std::setw(30) << label << std::right
+           << std::setw(14) << value
+           << std::setw(10) << std::fixed << std::setprecision(3)
+           << percent(value) << " %" << G4endl;
+  };
+
+  G4cout
+    << G4endl
+    << "------------------------ Photon budget ------------------------"
+    << G4endl
+    << " " << std::left << std::setw(30) << "Created (all)" << std::right
+    << std::setw(14) << created << G4endl;
+  line("  scintillation in QD", kCreatedScintQD);
+  line("  scintillation in Bottle", kCreatedScintBottle);
+  line("  scintillation elsewhere", kCreatedScintOther);
+  line("  Cerenkov in QD", kCreatedCerenkovQD);
+  line("  Cerenkov in Bottle", kCreatedCerenkovBottle);
+  line("  Cerenkov elsewhere", kCreatedCerenkovOther);
+  line("  other processes", kCreatedOther);
+  line("Absorbed in QD", kAbsorbedQD);
+  line("Absorbed in Bottle", kAbsorbedBottle);
+  line("Absorbed in PMT", kAbsorbedPMT);
+  line("Absorbed elsewhere", kAbsorbedOther);
+  line("Absorbed at walls and stand", kAbsorbedWall);
+  line("Escaped the world", kEscaped);
+  line("Killed below 300 nm", kBelowCutoff);
+  line("Culled by the time gate", kCulled);
+  line("Suppressed (source disabled)", kSuppressed);
+  line("Reached PMT (>= 300 nm)", kReachedPMT);
+  line("Passed QE", kPassedQE);
+  line("Detected", kDetected);
+  line("Recorded (ntuple rows)", kRecorded);
+  G4cout
+    << "---------------------------------------------------------------"
+    << G4endl;
+  G4cout.unsetf(std::ios::fixed);
+  G4cout << std::setprecision(6);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
@@ -0,0 +1,65 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file PhotonHit.cc
+/// \brief Implementation of the B4c::PhotonHit class
+
+#include "PhotonHit.hh"
+#include "G4UnitsTable.hh"
+
+#include <iomanip>
+
+namespace B4c
+{
+
+PhotonHit::PhotonHit(G4double time, G4double wavelength,
+                     const PhotonTrackInfo::PathLengths& pathLengths,
+                     PhotonSources::Creator creator)
+ : fTime(time),
+   fWavelength(wavelength),
+   fPathLengths(pathLengths),
+   fCreator(creator)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhotonHit::Print() const
+{
+  G4cout
+     << "Time: "
+     << std::setw(7) << G4BestUnit(fTime,"Time")
+     << " wavelength: "
+     << std::setw(7) << fWavelength << " nm"
+     << " path in QD: " << G4BestUnit(fPathLengths[0],"Length")
+     << " Bottle: " << G4BestUnit(fPathLengths[1],"Length")
+     << " air: " << G4BestUnit(fPathLengths[2],"Length")
+     << " creator: " << fCreator
+     << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
@@ -0,0 +1,231 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file PhotonSources.cc
+/// \brief Implementation of the B4c::PhotonSources class
+
+#include "PhotonSources.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4OpProcessSubType.hh"
+#include "G4Threading.hh"
+#include "G4Track.hh"
+#include "G4VProcess.hh"
+
+namespace B4c
+{
+
+G4ThreadLocal PhotonSources* PhotonSources::fgInstance = nullptr;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PhotonSources* PhotonSources::Instance()
+{
+  if ( ! fgInstance ) {
+    fgInstance = new PhotonSources();
+  }
+  return fgInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PhotonSources::PhotonSources()
+{
+  fMessenger = new G4GenericMessenger(this, "/B4/sources/",
+                                      "Optical photon sources per volume");
+
+  auto& noScintCmd = fMessenger->DeclareMethod("disableScintillation",
+    &PhotonSources::DisableScintillation,
+    "Kill the scintillation photons created in a logical volume (or all).");
+  noScintCmd.SetParameterName("volume", false);
+
+  auto& scintCmd = fMessenger->DeclareMethod("enableScintillation",
+    &PhotonSources::EnableScintillation,
+    "Keep the scintillation photons created in a logical volume (or all).");
+  scintCmd.SetParameterName("volume", false);
+
+  auto& noCerenkovCmd = fMessenger->DeclareMethod("disableCerenkov",
+    &PhotonSources::DisableCerenkov,
+    "Kill the Cerenkov photons created in a logical volume (or all).");
+  noCerenkovCmd.SetParameterName("volume", false);
+
+  auto& cerenkovCmd = fMessenger->DeclareMethod("enableCerenkov",
+    &PhotonSources::EnableCerenkov,
+    "Keep the Cerenkov photons created in a logical volume (or all).");
+  cerenkovCmd.SetParameterName("volume", false);
+
+  fMessenger->DeclareMethod("list", &PhotonSources::List,
+    "Print the volumes with a disabled photon source.");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PhotonSources::~PhotonSources()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PhotonSources::Creator PhotonSources::GetCreator(const G4Track* track)
+{
+  auto process = track->GetCreatorProcess();
+  if ( ! process ) return kOther;
+  switch ( process->GetProcessSubType() ) {
+    case fScintillation: return kScintillation;
+    case fCerenkov:      return kCerenkov;
+    default:             return kOther;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PhotonSources::Switches::IsEnabled(
+  const G4LogicalVolume* volume) const
+{
+  auto isException = volume && exceptions.count(volume->GetName()) > 0;
+  return disabledInAll == isException;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PhotonSources::IsEnabled(Creator creator,
+                                const G4LogicalVolume* volume)
+{
+  if ( creator == kOther ) return true;
+  if ( ! fScintillationSwitches.IsRestricted()
+       && ! fCerenkovSwitches.IsRestricted() ) {
+    return true;
+  }
+
+  auto it = fCache.find(volume);
+  if ( it == fCache.end() ) {
+    CheckVolumes();
+    it = fCache.emplace(volume,
+      std::make_pair(fScintillationSwitches.IsEnabled(volume),
+                     fCerenkovSwitches.IsEnabled(volume))).first;
+  }
+  return ( creator == kScintillation ) ? it->second.first : it->second.second;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhotonSources::DisableScintillation(const G4String& volume)
+{
+  Set(fScintillationSwitches, volume, false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhotonSources::EnableScintillation(const G4String& volume)
+{
+  Set(fScintillationSwitches, volume, true);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhotonSources::DisableCerenkov(const G4String& volume)
+{
+  Set(fCerenkovSwitches, volume, false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhotonSources::EnableCerenkov(const G4String& volume)
+{
+  Set(fCerenkovSwitches, volume, true);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhotonSources::Set(Switches& switches, const G4String& volume,
+                        G4bool enabled)
+{
+  if ( volume == "all" ) {
+    // Also resets the volumes switched one by one
+    switches.disabledInAll = ! enabled;
+    switches.exceptions.clear();
+  }
+  else {
+    if ( enabled == switches.disabledInAll ) {
+      switches.exceptions.insert(volume);
+    }
+    else {
+      switches.exceptions.erase(volume);
+    }
+    fUncheckedVolumes.insert(volume);
+    CheckVolumes();
+  }
+  fCache.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhotonSources::CheckVolumes()
+{
+  auto store = G4LogicalVolumeStore::GetInstance();
+  if ( fUncheckedVolumes.empty() || store->empty() ) return;
+
+  // Warn once per job: on the master, or on the first worker which
+  // gets the commands after the geometry is built
+  if ( G4Threading::G4GetThreadId() <= 0 ) {
+    for ( const auto& volume : fUncheckedVolumes ) {
+      if ( store->GetVolume(volume, false) ) continue;
+      G4ExceptionDescription msg;
+      msg << "No logical volume " << volume << ": its photon source "
+          << "switch has no effect.";
+      G4Exception("PhotonSources::CheckVolumes()",
+        "MyCode0016", JustWarning, msg);
+    }
+  }
+  fUncheckedVolumes.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PhotonSources::List()
+{
+  auto print = [](const char* source, const Switches& switches) {
+    G4cout << " " << source << " disabled in:";
+    if ( switches.disabledInAll ) {
+      G4cout << " all";
+      if ( ! switches.exceptions.empty() ) G4cout << " except";
+    }
+    else if ( switches.exceptions.empty() ) {
+      G4cout << " none";
+    }
+    for ( const auto& volume : switches.exceptions ) G4cout << " " << volume;
+    G4cout << G4endl;
+  };
+  print("Scintillation", fScintillationSwitches);
+  print("Cerenkov", fCerenkovSwitches);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
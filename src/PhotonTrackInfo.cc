@@ -0,0 +1,68 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file PhotonTrackInfo.cc
+/// \brief Implementation of the B4c::PhotonTrackInfo class
+
+#include "PhotonTrackInfo.hh"
+
+#include "G4ScintillationTrackInformation.hh"
+#include "G4Track.hh"
+
+namespace B4c
+{
+
+G4ThreadLocal G4Allocator<PhotonTrackInfo>* PhotonTrackInfoAllocator = nullptr;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PhotonTrackInfo* PhotonTrackInfo::Attach(const G4Track* track)
+{
+  auto userInfo = track->GetUserInformation();
+  if ( auto info = dynamic_cast<PhotonTrackInfo*>(userInfo) ) return info;
+
+  auto info = new PhotonTrackInfo();
+  if ( auto scintInfo
+         = dynamic_cast<const G4ScintillationTrackInformation*>(userInfo) ) {
+    info->fScintillationType = G4int(scintInfo->GetScintillationType());
+  }
+  // The track owns its information; the replaced one is deleted here
+  delete userInfo;
+  track->SetUserInformation(info);
+  return info;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const char* PhotonTrackInfo::GetName(Path path)
+{
+  static const char* names[kNofPaths] = { "PathQD", "PathBottle", "PathAir" };
+  return names[path];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
@@ -1,4 +1,7 @@
 #include "PrimaryGeneratorAction.hh"
+#include "EventSeeder.hh"
+#include "EventTimer.hh"
+#include "PerfCounters.hh"
 #include "G4GeneralParticleSource.hh"
 
 namespace B4
@@ -18,6 +21,15 @@ PrimaryGeneratorAction::~PrimaryGeneratorAction()
 
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 {
+    B4c::PerfCounters::Scope perfScope(B4c::PerfCounters::kGeneratePrimaries);
+
+    // Thread-count independent seeding, before any random number is used
+    auto seeder = B4c::EventSeeder::Instance();
+    if ( seeder->IsEnabled() ) seeder->Seed(anEvent->GetEventID());
+
+    // Start of the event timing; keeps or replays the random state
+    B4c::EventTimer::Instance()->BeginOfEvent();
+
 //   // Set gun position
 //   fParticleGun
 //    ->SetParticlePosition(G4ThreeVector(0., 0., 0.));
@@ -28,12 +28,31 @@
 /// \brief Implementation of the B4::RunAction class
 
 #include "RunAction.hh"
+#include "CompactOutput.hh"
+#include "EventSeeder.hh"
+#include "EventTimer.hh"
+#include "HDF5Output.hh"
+#include "KillZone.hh"
+#include "LazyPhotons.hh"
+#include "OutputSchema.hh"
+#include "PMTDigitizer.hh"
+#include "PerfCounters.hh"
+#include "PhotonCounters.hh"
+#include "PhotonSources.hh"
+#include "RunMonitor.hh"
+#include "StepProfiler.hh"
+#include "TimeGate.hh"
+#include "TrajectorySampler.hh"
 
+#include "G4AccumulableManager.hh"
 #include "G4AnalysisManager.hh"
+#include "G4DigiManager.hh"
+#include "G4GenericMessenger.hh"
 #include "G4Run.hh"
 #include "G4RunManager.hh"
 #include "G4UnitsTable.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
 
 namespace B4
 {
@@ -45,6 +64,31 @@ RunAction::RunAction()
   // set printing event number per each event
   G4RunManager::GetRunManager()->SetPrintProgress(1);
 
+  // Register the photon counters accumulables on this thread
+  B4c::PhotonCounters::Instance();
+  // Create the step profiler and its commands on this thread
+  B4c::StepProfiler::Instance();
+  // Create the per-event seeding commands on this thread
+  B4c::EventSeeder::Instance();
+  // Create the lazy photon generation commands on this thread
+  B4c::LazyPhotons::Instance();
+  // Create the acquisition time gate commands on this thread
+  B4c::TimeGate::Instance();
+  // Create the trajectory sampling commands on this thread
+  B4c::TrajectorySampler::Instance();
+  // Create the per-volume photon source switches on this thread
+  B4c::PhotonSources::Instance();
+  // Register the kill zone accumulables on this thread
+  B4c::KillZone::Instance();
+  // Create the HDF5 photon output commands on this thread
+  B4c::HDF5Output::Instance();
+  // Create the performance counter commands on this thread
+  B4c::PerfCounters::Instance();
+  // Create the per-event timing commands on this thread
+  B4c::EventTimer::Instance();
+
+  DefineCommands();
+
   // Create analysis manager
   // The choice of the output format is done via the specified
   // file extension.
@@ -54,80 +98,165 @@ RunAction::RunAction()
   //analysisManager->SetHistoDirectoryName("histograms");
   //analysisManager->SetNtupleDirectoryName("ntuple");
   analysisManager->SetVerboseLevel(1);
-  analysisManager->SetNtupleMerging(true);
-    // Note: merging ntuples is available only with Root output
+  // The photon ntuple is deactivated with /B4/output/photons compact
+  // or hdf5
+  analysisManager->SetActivation(true);
+  // Note: ntuple merging (or sharding) is chosen in BeginOfRunAction()
 
   // Book histograms, ntuple
+  // (the layout is shared with the offline tools, see OutputSchema.cc)
   //
+  B4c::CreateHistograms();
+  B4c::CreateNtuples();
 
-  // Creating histograms
-  analysisManager->CreateH1("Counter","Counter", 50, 0. ,30000);
-  //analysisManager->CreateH1("Egap","Edep in gap", 100, 0., 100*MeV);
-  //analysisManager->CreateH1("Labs","trackL in absorber", 100, 0., 1*m);
-  //analysisManager->CreateH1("Lgap","trackL in gap", 100, 0., 50*cm);
-
-  // Creating ntuple
-  //
-  analysisManager->CreateNtuple("B4", "Photons Detected");
-  //analysisManager->CreateNtupleDColumn("Eabs");
-  //analysisManager->CreateNtupleDColumn("Egap");
-  //analysisManager->CreateNtupleDColumn("Labs");
-  //analysisManager->CreateNtupleDColumn("Lgap");
-  //analysisManager->CreateNtupleDColumn("Count");
-  analysisManager->CreateNtupleDColumn("Event");
-  analysisManager->CreateNtupleDColumn("Wavelength");
-  //analysisManager->CreateNtupleDColumn("Energy");
-  analysisManager->CreateNtupleDColumn("Time");
-  //analysisManager->CreateNtupleDColumn("Counter");
-  analysisManager->FinishNtuple(0);
-
-  analysisManager->CreateNtuple("Event", "Event");
-  analysisManager->CreateNtupleDColumn("Counter");
-  analysisManager->FinishNtuple(1);
-  
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 RunAction::~RunAction()
 {
+  delete fMessenger;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void RunAction::BeginOfRunAction(const G4Run* /*run*/)
+void RunAction::BeginOfRunAction(const G4Run* run)
 {
+  fRunStartTime = Clock::now();
+  if ( fInitTime < 0. ) {
+    fInitTime
+      = std::chrono::duration<G4double>(fRunStartTime - fCreationTime).count();
+  }
+
   //inform the runManager to save random number seed
   //G4RunManager::GetRunManager()->SetRandomNumberStore(true);
 
+  // reset accumulables to their initial values
+  G4AccumulableManager::Instance()->Reset();
+  B4c::StepProfiler::Instance()->BeginOfRun();
+  B4c::PerfCounters::Instance()->BeginOfRun();
+  B4c::EventTimer::Instance()->BeginOfRun();
+
+  auto monitor = B4c::RunMonitor::Instance();
+  if ( IsMaster() && monitor ) {
+    monitor->BeginOfRun(run->GetRunID(), run->GetNumberOfEventToBeProcessed());
+  }
+
   // Get analysis manager
   auto analysisManager = G4AnalysisManager::Instance();
 
+  // Merge the worker ntuples on the master, or let each worker write
+  // its own <fileName>_t<N> shard
+  // Note: merging ntuples is available only with Root output
+  if ( fFileType == "root" ) {
+    analysisManager->SetNtupleMerging(! fSharded);
+  }
+
   // Open an output file
+  // The choice of the output format is done via the file extension:
+  // root (default), csv, hdf5 or xml, see /B4/output/fileType
   //
-  G4String fileName = "B4.root";
-  // Other supported output types:
-  // G4String fileName = "B4.csv";
-  // G4String fileName = "B4.hdf5";
-  // G4String fileName = "B4.xml";
+  G4String fileName = fFileName + "." + fFileType;
+  auto hdf5Photons
+    = fPhotonFormat == "hdf5" && B4c::HDF5Output::IsAvailable();
+  analysisManager->SetNtupleActivation(0,
+    fPhotonFormat != "compact" && ! hdf5Photons);
   analysisManager->OpenFile(fileName);
 
+  // Compact or HDF5 photon stream, written by the threads processing events
+  if ( fPhotonFormat != "ntuple"
+       && ! ( IsMaster() && G4Threading::IsMultithreadedApplication() ) ) {
+    auto photonsName = fFileName;
+    if ( ! IsMaster() ) {
+      photonsName += "_t" + std::to_string(G4Threading::G4GetThreadId());
+    }
+    if ( fPhotonFormat == "hdf5" ) {
+      B4c::HDF5Output::Instance()->Open(photonsName + ".h5");
+    }
+    else {
+      B4c::CompactOutput::Instance()->Open(photonsName + ".b4p");
+    }
+  }
+
+  auto pmtDigitizer = static_cast<B4c::PMTDigitizer*>(
+    G4DigiManager::GetDMpointer()->FindDigitizerModule("PMTDigitizer"));
+  if ( pmtDigitizer ) pmtDigitizer->BeginOfRun();
+
   //G4cout << "Using " << analysisManager->GetType() << G4endl;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void RunAction::EndOfRunAction(const G4Run* /*run*/)
+void RunAction::EndOfRunAction(const G4Run* run)
 {
+  // Merge accumulables
+  G4AccumulableManager::Instance()->Merge();
+
+  if ( IsMaster() ) {
+    B4c::PhotonCounters::Instance()->Print();
+    auto killZone = B4c::KillZone::Instance();
+    if ( killZone->IsEnabled() ) killZone->Print();
+
+    std::chrono::duration<G4double> loopTime = Clock::now() - fRunStartTime;
+    G4cout
+      << "--> Run " << run->GetRunID() << " timing: "
+      << run->GetNumberOfEvent() << " events, initialisation "
+      << fInitTime << " s, event loop " << loopTime.count() << " s"
+      << G4endl;
+  }
+  B4c::StepProfiler::Instance()->EndOfRun(IsMaster());
+  B4c::EventTimer::Instance()->EndOfRun(IsMaster(), run->GetRunID());
+
   // print histogram statistics
   //
   auto analysisManager = G4AnalysisManager::Instance();
   // save histograms & ntuple
   //
-  analysisManager->Write();
-  analysisManager->CloseFile();
+  {
+    B4c::PerfCounters::Scope scope(B4c::PerfCounters::kOutput);
+    analysisManager->Write();
+    analysisManager->CloseFile();
+    B4c::CompactOutput::Instance()->Close();
+    B4c::HDF5Output::Instance()->Close();
+  }
+  B4c::PerfCounters::Instance()->EndOfRun(IsMaster(), run->GetRunID());
+
+  auto pmtDigitizer = static_cast<B4c::PMTDigitizer*>(
+    G4DigiManager::GetDMpointer()->FindDigitizerModule("PMTDigitizer"));
+  if ( pmtDigitizer ) pmtDigitizer->EndOfRun();
 }
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/B4/output/",
+                                      "Output file control");
+
+  auto& nameCmd = fMessenger->DeclareProperty("fileName", fFileName,
+    "Output file name without extension.");
+  nameCmd.SetParameterName("name", false);
 
+  auto& typeCmd = fMessenger->DeclareProperty("fileType", fFileType,
+    "Output format; the worker ntuples are merged only with root.");
+  typeCmd.SetCandidates("root csv hdf5 xml");
+  typeCmd.AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  auto& shardedCmd = fMessenger->DeclareProperty("sharded", fSharded,
+    "Each worker writes its ntuples to its own <fileName>_t<N> file; "
+    "combine them with b4merge.");
+  shardedCmd.SetParameterName("flag", true);
+  shardedCmd.SetDefaultValue("true");
+  shardedCmd.AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  auto& photonsCmd = fMessenger->DeclareProperty("photons", fPhotonFormat,
+    "Detected photons output: the B4 ntuple, the compact .b4p encoding "
+    "(one file per thread, read with b4decode or b4analysis), both, or "
+    "HDF5 datasets (one .h5 file per thread, see /B4/hdf5/).");
+  photonsCmd.SetCandidates("ntuple compact both hdf5");
+  photonsCmd.AvailableForStates(G4State_PreInit, G4State_Idle);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 }
@@ -0,0 +1,474 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file RunFarm.cc
+/// \brief Implementation of the B4c::RunFarm class
+
+#include "RunFarm.hh"
+#include "Checkpoint.hh"
+#include "RunAction.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4RunManager.hh"
+#include "G4UIcommand.hh"
+#include "G4UImanager.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace B4c
+{
+
+namespace
+{
+  const G4int kMaxRetries = 2;
+
+  // Launcher view of one shard process
+  struct Shard
+  {
+    pid_t pid = -1;
+    int fd = -1;           // read end of the progress pipe
+    G4int attempts = 0;
+    G4long eventsDone = 0;
+    G4long eventsToDo = 0;
+    G4bool done = false;
+    G4bool failed = false;
+    std::string buffer;    // incomplete line read from the pipe
+    std::vector<std::pair<std::string, std::string>> files; // output, file
+  };
+
+  std::vector<char*> MakeArgv(const std::vector<std::string>& args)
+  {
+    std::vector<char*> argv;
+    for ( const auto& arg : args ) {
+      argv.push_back(const_cast<char*>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    return argv;
+  }
+
+  // Forks and execs shard `index`, with its output to farm_p<index>.log;
+  // the log of a restarted shard is appended to, after a separator line
+  G4bool Start(Shard& shard, G4int index, G4int nofShards,
+               std::vector<std::string> args)
+  {
+    int fds[2];
+    if ( pipe(fds) != 0 ) return false;
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+
+    args.push_back("-p");
+    args.push_back(std::to_string(index) + ":" + std::to_string(nofShards));
+    auto argv = MakeArgv(args);
+    auto log = "farm_p" + std::to_string(index) + ".log";
+
+    auto pid = fork();
+    if ( pid < 0 ) {
+      close(fds[0]);
+      close(fds[1]);
+      return false;
+    }
+    if ( pid == 0 ) {
+      setenv("B4_FARM_FD", std::to_string(fds[1]).c_str(), 1);
+      auto mode = ( shard.attempts == 0 ) ? O_TRUNC : O_APPEND;
+      auto logFd = open(log.c_str(), O_WRONLY | O_CREAT | mode, 0644);
+      if ( logFd >= 0 ) {
+        dup2(logFd, STDOUT_FILENO);
+        dup2(logFd, STDERR_FILENO);
+        close(logFd);
+      }
+      if ( shard.attempts > 0 ) {
+        auto separator = "\n--> Farm: restart " + std::to_string(shard.attempts)
+                       + " of shard " + std::to_string(index) + "\n\n";
+        auto written = write(STDOUT_FILENO, separator.data(), separator.size());
+        (void)written;
+      }
+      execvp(argv[0], argv.data());
+      _exit(127);
+    }
+
+    close(fds[1]);
+    shard.pid = pid;
+    shard.fd = fds[0];
+    ++shard.attempts;
+    shard.eventsDone = 0;
+    shard.eventsToDo = 0;
+    shard.buffer.clear();
+    shard.files.clear();
+    return true;
+  }
+
+  // Handles the complete lines received from a shard
+  void ParseLines(Shard& shard)
+  {
+    std::string::size_type end;
+    while ( ( end = shard.buffer.find('\n') ) != std::string::npos ) {
+      auto line = shard.buffer.substr(0, end);
+      shard.buffer.erase(0, end + 1);
+
+      if ( line.compare(0, 9, "progress ") == 0 ) {
+        auto separator = line.find(' ', 9);
+        if ( separator == std::string::npos ) continue;
+        shard.eventsDone = std::atol(line.substr(9, separator - 9).c_str());
+        shard.eventsToDo = std::atol(line.substr(separator + 1).c_str());
+      }
+      else if ( line.compare(0, 5, "file ") == 0 ) {
+        auto separator = line.find(' ', 5);
+        if ( separator == std::string::npos ) continue;
+        std::pair<std::string, std::string> file(
+          line.substr(5, separator - 5), line.substr(separator + 1));
+        if ( std::find(shard.files.begin(), shard.files.end(), file)
+             == shard.files.end() ) {
+          shard.files.push_back(file);
+        }
+      }
+    }
+  }
+
+  void PrintProgress(const std::vector<Shard>& shards)
+  {
+    G4cout << "--> Farm:";
+    for ( std::size_t k = 0; k < shards.size(); ++k ) {
+      const auto& shard = shards[k];
+      G4cout << " p" << k << " ";
+      if ( shard.failed ) {
+        G4cout << "failed";
+      }
+      else if ( shard.done ) {
+        G4cout << "done";
+      }
+      else {
+        G4cout << ( shard.eventsToDo > 0
+                    ? 100 * shard.eventsDone / shard.eventsToDo : 0 ) << "%";
+      }
+    }
+    G4cout << G4endl;
+  }
+
+  // Runs a command and returns its exit code (-1 if it could not run)
+  G4int Run(const std::vector<std::string>& args)
+  {
+    auto argv = MakeArgv(args);
+    auto pid = fork();
+    if ( pid < 0 ) return -1;
+    if ( pid == 0 ) {
+      execvp(argv[0], argv.data());
+      _exit(127);
+    }
+    int status = 0;
+    while ( waitpid(pid, &status, 0) < 0 && errno == EINTR ) {}
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+  }
+}
+
+G4int RunFarm::fgProgressFd = -1;
+std::atomic<G4long> RunFarm::fgEventsDone(0);
+G4long RunFarm::fgEventsToDo = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RunFarm::RunFarm(const G4String& shard)
+{
+  auto colon = shard.find(':');
+  fShard = G4UIcommand::ConvertToInt(shard.substr(0, colon));
+  if ( colon != std::string::npos ) {
+    fNofShards = G4UIcommand::ConvertToInt(shard.substr(colon + 1));
+  }
+  if ( fNofShards < 1 || fShard < 0 || fShard >= fNofShards ) {
+    G4ExceptionDescription msg;
+    msg << "Invalid farm shard " << shard << " (expected k:N, 0 <= k < N)";
+    G4Exception("RunFarm::RunFarm()", "MyCode0009", FatalException, msg);
+  }
+
+  if ( auto fd = std::getenv("B4_FARM_FD") ) {
+    fgProgressFd = std::atoi(fd);
+  }
+
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RunFarm::~RunFarm()
+{
+  delete fMessenger;
+  if ( fgProgressFd >= 0 ) {
+    close(fgProgressFd);
+    fgProgressFd = -1;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunFarm::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/B4/farm/",
+                                      "Multi-process run farm shard");
+
+  auto& beamOnCmd = fMessenger->DeclareMethod("beamOn", &RunFarm::BeamOn,
+    "Process the events of this shard out of a run of nofEvents.");
+  beamOnCmd.SetParameterName("nofEvents", false);
+  beamOnCmd.SetRange("nofEvents>=0");
+  beamOnCmd.AvailableForStates(G4State_PreInit, G4State_Idle);
+  beamOnCmd.command->SetToBeBroadcasted(false);
+
+  auto& outputCmd = fMessenger->DeclareProperty("output", fOutputName,
+    "Output name: the shards write <output>_p<k>, merged to <output>.");
+  outputCmd.SetParameterName("name", false);
+  outputCmd.command->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String RunFarm::PrepareMacro(const G4String& macro) const
+{
+  std::ifstream input(macro);
+  if ( ! input ) return macro;  // reported by /control/execute
+
+  G4String shardMacro = "farm_p" + std::to_string(fShard) + ".mac";
+  std::ofstream output(shardMacro);
+  output
+    << "# Shard " << fShard << " of " << fNofShards << " of " << macro << "\n"
+    << "/B4/random/perEventSeeding true\n";
+
+  const std::string beamOn = "/run/beamOn";
+  std::string line;
+  while ( std::getline(input, line) ) {
+    auto start = line.find_first_not_of(" \t");
+    if ( start != std::string::npos
+         && line.compare(start, beamOn.size(), beamOn) == 0 ) {
+      line = line.substr(0, start) + "/B4/farm/beamOn"
+           + line.substr(start + beamOn.size());
+    }
+    output << line << "\n";
+  }
+  return shardMacro;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunFarm::BeamOn(G4int nofEvents)
+{
+  auto first = G4long(nofEvents) * fShard / fNofShards;
+  auto last = G4long(nofEvents) * (fShard + 1) / fNofShards;
+
+  // Only the shard file is reported and merged: the worker ntuples must
+  // be merged in it, not written to _t<N> files
+  auto uiManager = G4UImanager::GetUIpointer();
+  auto runManager = G4RunManager::GetRunManager();
+  auto runAction
+    = dynamic_cast<const B4::RunAction*>(runManager->GetUserRunAction());
+  if ( runAction && runAction->IsSharded() ) {
+    G4ExceptionDescription msg;
+    msg << "/B4/output/sharded is not supported in a farm shard: "
+        << "switched off, the farm merges the shard files itself.";
+    G4Exception("RunFarm::BeamOn()", "MyCode0015", JustWarning, msg);
+    uiManager->ApplyCommand("/B4/output/sharded false");
+  }
+
+  uiManager->ApplyCommand(
+    "/B4/output/fileName " + fOutputName + "_p" + std::to_string(fShard));
+  Checkpoint::SetEventOffset(G4int(first));
+  fgEventsDone = 0;
+  fgEventsToDo = last - first;
+  Report("progress 0 " + std::to_string(fgEventsToDo));
+
+  runManager->BeamOn(G4int(last - first));
+  Checkpoint::SetEventOffset(0);
+
+  if ( runAction ) {
+    Report("file " + fOutputName + " " + runAction->GetFileName());
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunFarm::Report(const G4String& line)
+{
+  if ( fgProgressFd < 0 ) return;
+
+  // A line shorter than PIPE_BUF is written atomically by any thread
+  auto text = line + "\n";
+  auto written = write(fgProgressFd, text.data(), text.size());
+  (void)written;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunFarm::EndOfEvent()
+{
+  if ( fgProgressFd < 0 ) return;
+
+  auto done = ++fgEventsDone;
+  auto step = std::max<G4long>(1, fgEventsToDo / 100);
+  if ( done % step == 0 || done == fgEventsToDo ) {
+    Report("progress " + std::to_string(done) + " "
+           + std::to_string(fgEventsToDo));
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int RunFarm::Launch(G4int argc, char** argv, G4int nofProcesses)
+{
+  // The shards get the same command line, without -j
+  std::vector<std::string> args;
+  for ( G4int i = 0; i < argc; ++i ) {
+    if ( std::string(argv[i]) == "-j" ) {
+      ++i;
+      continue;
+    }
+    args.push_back(argv[i]);
+  }
+
+  std::vector<Shard> shards(nofProcesses);
+  for ( G4int k = 0; k < nofProcesses; ++k ) {
+    if ( ! Start(shards[k], k, nofProcesses, args) ) {
+      G4cerr << "--> Farm: cannot start shard " << k << G4endl;
+      return 1;
+    }
+  }
+  G4cout << "--> Farm: " << nofProcesses << " processes started, "
+         << "logs in farm_p<k>.log" << G4endl;
+
+  // Progress, completion and retries
+  using Clock = std::chrono::steady_clock;
+  auto lastPrint = Clock::now();
+  while ( true ) {
+    std::vector<pollfd> fds;
+    std::vector<G4int> owners;
+    for ( G4int k = 0; k < nofProcesses; ++k ) {
+      if ( shards[k].fd < 0 ) continue;
+      fds.push_back({shards[k].fd, POLLIN, 0});
+      owners.push_back(k);
+    }
+    if ( fds.empty() ) break;
+
+    poll(fds.data(), fds.size(), 1000);
+    for ( std::size_t i = 0; i < fds.size(); ++i ) {
+      if ( ! fds[i].revents ) continue;
+      auto k = owners[i];
+      auto& shard = shards[k];
+
+      char buffer[4096];
+      auto size = read(shard.fd, buffer, sizeof(buffer));
+      if ( size > 0 ) {
+        shard.buffer.append(buffer, size);
+        ParseLines(shard);
+        continue;
+      }
+      if ( size < 0 && errno == EINTR ) continue;
+
+      // The shard has exited
+      close(shard.fd);
+      shard.fd = -1;
+      int status = 0;
+      while ( waitpid(shard.pid, &status, 0) < 0 && errno == EINTR ) {}
+      if ( WIFEXITED(status) && WEXITSTATUS(status) == 0 ) {
+        shard.done = true;
+        continue;
+      }
+
+      G4cerr << "--> Farm: shard " << k << " failed ("
+             << ( WIFSIGNALED(status) ? "signal " : "exit code " )
+             << ( WIFSIGNALED(status) ? WTERMSIG(status)
+                                      : WEXITSTATUS(status) )
+             << "), see farm_p" << k << ".log" << G4endl;
+      if ( shard.attempts > kMaxRetries ) {
+        shard.failed = true;
+      }
+      else {
+        G4cerr << "--> Farm: restarting shard " << k << " (retry "
+               << shard.attempts << " of " << kMaxRetries << ")" << G4endl;
+        if ( ! Start(shard, k, nofProcesses, args) ) shard.failed = true;
+      }
+    }
+
+    if ( Clock::now() - lastPrint >= std::chrono::seconds(1) ) {
+      PrintProgress(shards);
+      lastPrint = Clock::now();
+    }
+  }
+  PrintProgress(shards);
+
+  if ( std::any_of(shards.begin(), shards.end(),
+                   [](const Shard& shard) { return shard.failed; }) ) {
+    G4cerr << "--> Farm: failed shards, the output is not merged" << G4endl;
+    return 1;
+  }
+
+  // Merge the shard outputs of each run: <output>_p<k>.root -> <output>.root
+  std::map<std::string, std::vector<std::string>> outputs;
+  for ( const auto& shard : shards ) {
+    for ( const auto& file : shard.files ) {
+      outputs[file.first].push_back(file.second);
+    }
+  }
+  auto merger = args[0];
+  auto slash = merger.rfind('/');
+  merger = ( slash == std::string::npos )
+         ? "b4merge" : merger.substr(0, slash + 1) + "b4merge";
+
+  G4int exitCode = 0;
+  for ( const auto& output : outputs ) {
+    const auto& files = output.second;
+    auto isRoot = [](const std::string& file) {
+      return file.size() > 5 && file.compare(file.size() - 5, 5, ".root") == 0;
+    };
+    if ( ! std::all_of(files.begin(), files.end(), isRoot) ) {
+      G4cout << "--> Farm: " << output.first << " not merged "
+             << "(b4merge reads ROOT files only)" << G4endl;
+      continue;
+    }
+    std::vector<std::string> command = { merger, "-o", output.first + ".root" };
+    command.insert(command.end(), files.begin(), files.end());
+    auto code = Run(command);
+    if ( code != 0 ) {
+      G4cerr << "--> Farm: merging " << output.first << ".root failed ("
+             << merger << " exit code " << code << ")" << G4endl;
+      exitCode = 1;
+    }
+    else {
+      G4cout << "--> Farm: " << files.size() << " shards merged to "
+             << output.first << ".root" << G4endl;
+    }
+  }
+  return exitCode;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
@@ -0,0 +1,466 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file RunMonitor.cc
+/// \brief Implementation of the B4c::RunMonitor class
+
+#include "RunMonitor.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4Threading.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define B4_MONITOR_SOCKETS 1
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+namespace B4c
+{
+
+RunMonitor* RunMonitor::fgInstance = nullptr;
+G4ThreadLocal RunMonitor::ThreadData* RunMonitor::fgThreadData = nullptr;
+
+namespace {
+  // Histogram ranges; the photon count range is the one of the "Counter" H1
+  const G4double kCounterMax = 30000.;
+  const G4double kTimeMax = 200.*ns;
+  const G4double kWavelengthMin = 200.;  // nm
+  const G4double kWavelengthMax = 800.;  // nm
+
+  template <std::size_t N>
+  void Fill(std::array<G4long, N>& bins, G4double value,
+            G4double min, G4double max)
+  {
+    if ( value < min || value >= max ) return;
+    auto bin = std::size_t((value - min) / (max - min) * N);
+    ++bins[std::min(bin, N - 1)];
+  }
+
+  template <std::size_t N>
+  void WriteHistogram(std::ostream& out, const char* name,
+                      G4double min, G4double max,
+                      const std::array<G4long, N>& bins)
+  {
+    out << "\"" << name << "\":{\"min\":" << min << ",\"max\":" << max
+        << ",\"bins\":[";
+    for ( std::size_t i = 0; i < N; ++i ) {
+      out << ( i ? "," : "" ) << bins[i];
+    }
+    out << "]}";
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunMonitor::Slot::Add(const Slot& other)
+{
+  events += other.events;
+  photons += other.photons;
+  peakStackDepth = std::max(peakStackDepth, other.peakStackDepth);
+  for ( G4int i = 0; i < kCounterBins; ++i ) counter[i] += other.counter[i];
+  for ( G4int i = 0; i < kTimeBins; ++i ) time[i] += other.time[i];
+  for ( G4int i = 0; i < kWavelengthBins; ++i ) {
+    wavelength[i] += other.wavelength[i];
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RunMonitor::RunMonitor()
+  : fInterval(2.*s)
+{
+  fgInstance = this;
+  DefineCommands();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RunMonitor::~RunMonitor()
+{
+  Stop();
+  delete fMessenger;
+  fgInstance = nullptr;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunMonitor::BeginOfRun(G4int runID, G4int nofEvents)
+{
+  if ( ! IsEnabled() ) return;
+
+  std::lock_guard<std::mutex> lock(fSnapshotMutex);
+  // Values of the previous run still in the slots are discarded too
+  Drain();
+  {
+    std::lock_guard<std::mutex> threadsLock(fThreadsMutex);
+    for ( auto& data : fThreads ) {
+      data->total = Slot();
+      data->recentStackDepth = 0;
+    }
+  }
+  fRunID = runID;
+  fNofEventsToProcess = nofEvents;
+  fRunStart = fLastTime = Clock::now();
+  fLastEvents = fLastPhotons = 0;
+  fEventRate = fPhotonRate = 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RunMonitor::ThreadData* RunMonitor::GetThreadData()
+{
+  if ( ! fgThreadData ) {
+    std::lock_guard<std::mutex> lock(fThreadsMutex);
+    fThreads.push_back(std::make_unique<ThreadData>());
+    fgThreadData = fThreads.back().get();
+    fgThreadData->threadID = G4Threading::G4GetThreadId();
+  }
+  return fgThreadData;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunMonitor::AddPhoton(G4double time, G4double wavelength)
+{
+  auto& event = GetThreadData()->event;
+  ++event.photons;
+  Fill(event.time, time, 0., kTimeMax);
+  Fill(event.wavelength, wavelength, kWavelengthMin, kWavelengthMax);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunMonitor::UpdateStackDepth(G4int depth)
+{
+  auto& event = GetThreadData()->event;
+  event.peakStackDepth = std::max(event.peakStackDepth, depth);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunMonitor::EndOfEvent()
+{
+  auto data = GetThreadData();
+  auto& event = data->event;
+  event.events = 1;
+  Fill(event.counter, G4double(event.photons), 0., kCounterMax);
+
+  // Announce the slot before writing it; if the monitor flipped the
+  // epoch in between, use the new slot (see TakeSnapshot())
+  G4int slot;
+  do {
+    slot = data->active.load();
+    data->writing.store(slot);
+  } while ( data->active.load() != slot );
+  data->slots[slot].Add(event);
+  data->writing.store(-1);
+
+  event = Slot();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunMonitor::Drain()
+{
+  std::lock_guard<std::mutex> lock(fThreadsMutex);
+  for ( auto& data : fThreads ) {
+    auto previous = data->active.load();
+    data->active.store(1 - previous);
+    while ( data->writing.load() == previous ) {
+      std::this_thread::yield();
+    }
+    auto& slot = data->slots[previous];
+    data->recentStackDepth = slot.peakStackDepth;
+    data->total.Add(slot);
+    slot = Slot();
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunMonitor::TakeSnapshot()
+{
+  std::lock_guard<std::mutex> lock(fSnapshotMutex);
+  Drain();
+
+  G4long events = 0;
+  G4long photons = 0;
+  {
+    std::lock_guard<std::mutex> threadsLock(fThreadsMutex);
+    for ( const auto& data : fThreads ) {
+      events += data->total.events;
+      photons += data->total.photons;
+    }
+  }
+
+  auto now = Clock::now();
+  std::chrono::duration<G4double> elapsed = now - fLastTime;
+  if ( elapsed.count() > 0. ) {
+    fEventRate = ( events - fLastEvents ) / elapsed.count();
+    fPhotonRate = ( photons - fLastPhotons ) / elapsed.count();
+  }
+  fLastTime = now;
+  fLastEvents = events;
+  fLastPhotons = photons;
+
+  fJson = MakeJson();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::string RunMonitor::MakeJson() const
+{
+  std::lock_guard<std::mutex> lock(fThreadsMutex);
+
+  Slot sum;
+  for ( const auto& data : fThreads ) sum.Add(data->total);
+  std::chrono::duration<G4double> elapsed = fLastTime - fRunStart;
+
+  std::ostringstream out;
+  out << "{\"run\":" << fRunID
+      << ",\"elapsed\":" << elapsed.count()
+      << ",\"eventsToProcess\":" << fNofEventsToProcess
+      << ",\"events\":" << sum.events
+      << ",\"photons\":" << sum.photons
+      << ",\"eventRate\":" << fEventRate
+      << ",\"photonRate\":" << fPhotonRate
+      << ",\"eventsQueued\":"
+      << std::max(G4long(0), fNofEventsToProcess - sum.events)
+      << ",\"threads\":[";
+  for ( std::size_t i = 0; i < fThreads.size(); ++i ) {
+    const auto& data = *fThreads[i];
+    out << ( i ? "," : "" )
+        << "{\"id\":" << data.threadID
+        << ",\"events\":" << data.total.events
+        << ",\"photons\":" << data.total.photons
+        << ",\"stackDepth\":" << data.recentStackDepth
+        << ",\"peakStackDepth\":" << data.total.peakStackDepth << "}";
+  }
+  out << "],\"histograms\":{";
+  WriteHistogram(out, "Counter", 0., kCounterMax, sum.counter);
+  out << ",";
+  WriteHistogram(out, "Time", 0., kTimeMax/ns, sum.time);
+  out << ",";
+  WriteHistogram(out, "Wavelength", kWavelengthMin, kWavelengthMax,
+                 sum.wavelength);
+  out << "}}";
+  return out.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#ifdef B4_MONITOR_SOCKETS
+
+void RunMonitor::Start()
+{
+  if ( fThread.joinable() ) return;
+
+  int listenSocket = -1;
+  G4bool ok = false;
+  if ( ! fSocketPath.empty() ) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, fSocketPath.c_str(),
+                 sizeof(address.sun_path) - 1);
+    listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(fSocketPath.c_str());
+    ok = listenSocket >= 0
+      && bind(listenSocket, (sockaddr*)&address, sizeof(address)) == 0;
+  }
+  else {
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(std::uint16_t(fPort));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    ok = listenSocket >= 0
+      && setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR,
+                    &reuse, sizeof(reuse)) == 0
+      && bind(listenSocket, (sockaddr*)&address, sizeof(address)) == 0;
+  }
+  ok = ok && listen(listenSocket, 4) == 0;
+
+  if ( ! ok ) {
+    if ( listenSocket >= 0 ) close(listenSocket);
+    G4ExceptionDescription msg;
+    msg << "Cannot listen on "
+        << ( fSocketPath.empty() ? "port " + std::to_string(fPort)
+                                 : fSocketPath )
+        << ": " << std::strerror(errno);
+    G4Exception("RunMonitor::Start()",
+      "MyCode0008", JustWarning, msg);
+    return;
+  }
+
+  fStop = false;
+  fEnabled = true;
+  fThread = std::thread(&RunMonitor::Loop, this, listenSocket);
+  G4cout << "--> Run monitor serving on "
+         << ( fSocketPath.empty() ? "http://127.0.0.1:" + std::to_string(fPort)
+                                  : fSocketPath )
+         << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunMonitor::Loop(int listenSocket)
+{
+  auto interval = std::chrono::duration_cast<Clock::duration>(
+    std::chrono::duration<G4double>(fInterval/s));
+  auto next = Clock::now();
+  while ( ! fStop ) {
+    auto now = Clock::now();
+    if ( now >= next ) {
+      TakeSnapshot();
+      next = now + interval;
+    }
+
+    // Wake up at least every 100 ms to notice Stop()
+    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+      next - Clock::now()).count();
+    pollfd request = {listenSocket, POLLIN, 0};
+    if ( poll(&request, 1, int(std::clamp<long long>(wait, 0, 100))) > 0
+         && ( request.revents & POLLIN ) ) {
+      int client = accept(listenSocket, nullptr, nullptr);
+      if ( client >= 0 ) {
+        Serve(client);
+        close(client);
+      }
+    }
+  }
+  close(listenSocket);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunMonitor::Serve(int client) const
+{
+  std::string json;
+  {
+    std::lock_guard<std::mutex> lock(fSnapshotMutex);
+    json = fJson;
+  }
+
+  std::string reply;
+  if ( fSocketPath.empty() ) {
+    // Read (and ignore) the request; any path returns the snapshot
+    timeval timeout = {1, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    char request[2048];
+    recv(client, request, sizeof(request), 0);
+    reply = "HTTP/1.0 200 OK\r\n"
+            "Content-Type: application/json\r\n"
+            "Access-Control-Allow-Origin: *\r\n"
+            "Content-Length: " + std::to_string(json.size() + 1) + "\r\n"
+            "\r\n";
+  }
+  reply += json + "\n";
+
+  std::size_t sent = 0;
+  while ( sent < reply.size() ) {
+    auto n = send(client, reply.data() + sent, reply.size() - sent,
+                  MSG_NOSIGNAL);
+    if ( n <= 0 ) break;
+    sent += std::size_t(n);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunMonitor::Stop()
+{
+  if ( ! fThread.joinable() ) return;
+  fStop = true;
+  fThread.join();
+  fEnabled = false;
+  if ( ! fSocketPath.empty() ) unlink(fSocketPath.c_str());
+}
+
+#else
+
+void RunMonitor::Start()
+{
+  G4Exception("RunMonitor::Start()",
+    "MyCode0008", JustWarning, "The run monitor needs POSIX sockets");
+}
+
+void RunMonitor::Loop(int) {}
+void RunMonitor::Serve(int) const {}
+void RunMonitor::Stop() {}
+
+#endif
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunMonitor::DefineCommands()
+{
+  fMessenger = new G4GenericMessenger(this, "/B4/monitor/",
+                                      "Live run monitoring");
+
+  auto& startCmd = fMessenger->DeclareMethod("start", &RunMonitor::Start,
+    "Start serving JSON snapshots (HTTP on 127.0.0.1:<port> or <socket>).");
+  startCmd.command->SetToBeBroadcasted(false);
+
+  auto& stopCmd = fMessenger->DeclareMethod("stop", &RunMonitor::Stop,
+    "Stop the monitoring thread.");
+  stopCmd.command->SetToBeBroadcasted(false);
+
+  auto& portCmd = fMessenger->DeclareProperty("port", fPort,
+    "Localhost TCP port of the HTTP endpoint.");
+  portCmd.SetRange("port>0 && port<65536");
+  portCmd.command->SetToBeBroadcasted(false);
+
+  auto& socketCmd = fMessenger->DeclareProperty("socket", fSocketPath,
+    "Serve on this Unix domain socket instead of HTTP.");
+  socketCmd.command->SetToBeBroadcasted(false);
+
+  auto& intervalCmd = fMessenger->DeclarePropertyWithUnit("interval", "s",
+    fInterval, "Time between two snapshots.");
+  intervalCmd.SetParameterName("interval", false);
+  intervalCmd.SetRange("interval>0.");
+  intervalCmd.command->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
@@ -0,0 +1,110 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file StackingAction.cc
+/// \brief Implementation of the B4c::StackingAction class
+
+#include "StackingAction.hh"
+#include "EventTimer.hh"
+#include "KillZone.hh"
+#include "LazyPhotons.hh"
+#include "PhotonCounters.hh"
+#include "PhotonSources.hh"
+#include "PhotonTrackInfo.hh"
+#include "RunMonitor.hh"
+#include "TimeGate.hh"
+
+#include "G4OpticalPhoton.hh"
+#include "G4StackManager.hh"
+#include "G4Track.hh"
+
+namespace B4c
+{
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ClassificationOfNewTrack
+StackingAction::ClassifyNewTrack(const G4Track* track)
+{
+  if ( track->GetDefinition() == G4OpticalPhoton::Definition() ) {
+    auto counters = PhotonCounters::Instance();
+    counters->AddCreated(track);
+    // Primary photons have no creator, nor yet a volume
+    auto creator = PhotonSources::GetCreator(track);
+    auto volume = track->GetVolume();
+    if ( creator != PhotonSources::kOther && volume
+         && ! PhotonSources::Instance()->IsEnabled(creator,
+                volume->GetLogicalVolume()) ) {
+      counters->Add(PhotonCounters::kSuppressed);
+      return fKill;
+    }
+    auto gate = TimeGate::Instance();
+    if ( gate->IsEnabled() && gate->IsOutside(track) ) {
+      counters->Add(PhotonCounters::kCulled);
+      return fKill;
+    }
+    // Path length bookkeeping, in place of the scintillation track info
+    PhotonTrackInfo::Attach(track);
+  }
+  else {
+    auto killZone = KillZone::Instance();
+    if ( killZone->IsEnabled()
+         && killZone->IsToBeKilled(track, track->GetVolume()) ) {
+      killZone->Add(track);
+      return fKill;
+    }
+  }
+  auto monitor = RunMonitor::Instance();
+  if ( monitor && monitor->IsEnabled() ) {
+    monitor->UpdateStackDepth(stackManager->GetNUrgentTrack());
+  }
+  auto timer = EventTimer::Instance();
+  if ( timer->IsEnabled() ) {
+    timer->UpdateStackDepth(stackManager->GetNTotalTrack());
+  }
+  return fUrgent;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StackingAction::NewStage()
+{
+  auto lazy = LazyPhotons::Instance();
+  if ( lazy->IsEnabled() ) {
+    lazy->Materialise();
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StackingAction::PrepareNewEvent()
+{
+  LazyPhotons::Instance()->Clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
@@ -0,0 +1,263 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file StepProfiler.cc
+/// \brief Implementation of the B4c::StepProfiler class
+
+#include "StepProfiler.hh"
+
+#include "G4AutoLock.hh"
+#include "G4GenericMessenger.hh"
+#include "G4LogicalVolume.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4Step.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VProcess.hh"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <tuple>
+
+namespace B4c
+{
+
+namespace
+{
+  // Report merged from all threads, keyed by (volume, process, particle)
+  struct ReportEntry {
+    std::uint64_t steps = 0;
+    G4double seconds = 0.;
+  };
+  using ReportKey = std::tuple<G4String, G4String, G4String>;
+
+  G4Mutex reportMutex = G4MUTEX_INITIALIZER;
+  std::map<ReportKey, ReportEntry> report;
+}
+
+G4ThreadLocal StepProfiler* StepProfiler::fgInstance = nullptr;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StepProfiler* StepProfiler::Instance()
+{
+  if ( ! fgInstance ) {
+    fgInstance = new StepProfiler();
+  }
+  return fgInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StepProfiler::StepProfiler()
+ : fTable(1024)
+{
+  fMessenger = new G4GenericMessenger(this, "/B4/profile/",
+                                      "Step timing profiler control");
+  auto& enableCmd = fMessenger->DeclareProperty("enable", fEnabled,
+    "Time the steps per (volume, process, particle).");
+  enableCmd.SetParameterName("flag", true);
+  enableCmd.SetDefaultValue("true");
+
+  auto& linesCmd = fMessenger->DeclareProperty("lines", fNofLines,
+    "Number of lines of the end of run report.");
+  linesCmd.SetParameterName("lines", false);
+  linesCmd.SetRange("lines>0");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StepProfiler::~StepProfiler()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+StepProfiler::Entry&
+StepProfiler::Find(const G4LogicalVolume* volume, const G4VProcess* process,
+                   const G4ParticleDefinition* particle)
+{
+  auto hash = reinterpret_cast<std::uintptr_t>(volume)*0x9E3779B97F4A7C15ull
+            ^ reinterpret_cast<std::uintptr_t>(process)*0xC2B2AE3D27D4EB4Full
+            ^ reinterpret_cast<std::uintptr_t>(particle)*0x165667B19E3779F9ull;
+  hash ^= hash >> 29;
+
+  auto mask = fTable.size() - 1;
+  for ( auto i = hash & mask; ; i = (i + 1) & mask ) {
+    auto& entry = fTable[i];
+    if ( entry.particle == particle && entry.volume == volume
+         && entry.process == process ) {
+      return entry;
+    }
+    if ( ! entry.particle ) {
+      if ( 2*(fNofEntries + 1) > fTable.size() ) {
+        Grow();
+        return Find(volume, process, particle);
+      }
+      ++fNofEntries;
+      entry.volume = volume;
+      entry.process = process;
+      entry.particle = particle;
+      return entry;
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepProfiler::Grow()
+{
+  std::vector<Entry> old(2*fTable.size());
+  old.swap(fTable);
+  fNofEntries = 0;
+  for ( const auto& entry : old ) {
+    if ( ! entry.particle ) continue;
+    auto& moved = Find(entry.volume, entry.process, entry.particle);
+    moved.steps = entry.steps;
+    moved.ticks = entry.ticks;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepProfiler::BeginOfRun()
+{
+  for ( auto& entry : fTable ) entry = Entry();
+  fNofEntries = 0;
+  fRunStartTicks = ReadTicks();
+  fRunStartTime = std::chrono::steady_clock::now();
+  fLastTicks = fRunStartTicks;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepProfiler::Step(const G4Step* step)
+{
+  auto now = ReadTicks();
+
+  auto volume
+    = step->GetPreStepPoint()->GetPhysicalVolume()->GetLogicalVolume();
+  auto process = step->GetPostStepPoint()->GetProcessDefinedStep();
+  auto particle = step->GetTrack()->GetDefinition();
+
+  auto& entry = Find(volume, process, particle);
+  ++entry.steps;
+  entry.ticks += now - fLastTicks;
+
+  // Exclude the profiler itself from the next interval
+  fLastTicks = ReadTicks();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepProfiler::EndOfRun(G4bool isMaster)
+{
+  if ( ! fEnabled ) return;
+
+  // Calibrate ticks against the steady clock over the run
+  auto ticks = ReadTicks() - fRunStartTicks;
+  std::chrono::duration<G4double> elapsed
+    = std::chrono::steady_clock::now() - fRunStartTime;
+  auto secondsPerTick = ( ticks > 0 ) ? elapsed.count()/ticks : 0.;
+
+  {
+    G4AutoLock lock(&reportMutex);
+    for ( const auto& entry : fTable ) {
+      if ( ! entry.particle || ! entry.steps ) continue;
+      ReportKey key(entry.volume->GetName(),
+                    entry.process ? entry.process->GetProcessName() : "none",
+                    entry.particle->GetParticleName());
+      auto& merged = report[key];
+      merged.steps += entry.steps;
+      merged.seconds += entry.ticks*secondsPerTick;
+    }
+  }
+
+  if ( isMaster ) PrintReport();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void StepProfiler::PrintReport() const
+{
+  G4AutoLock lock(&reportMutex);
+
+  std::vector<std::pair<ReportKey, ReportEntry>> lines(report.begin(),
+                                                       report.end());
+  std::sort(lines.begin(), lines.end(), [](const auto& a, const auto& b) {
+    return a.second.seconds > b.second.seconds;
+  });
+  G4double total = 0.;
+  std::uint64_t totalSteps = 0;
+  for ( const auto& line : lines ) {
+    total += line.second.seconds;
+    totalSteps += line.second.steps;
+  }
+
+  G4cout
+    << G4endl
+    << "---------------------------- Step profile ----------------------------"
+    << G4endl
+    << std::left
+    << " " << std::setw(14) << "Volume" << std::setw(18) << "Process"
+    << std::setw(14) << "Particle" << std::right
+    << std::setw(14) << "Steps" << std::setw(12) << "Time [s]"
+    << std::setw(8) << "%" << std::setw(10) << "ns/step"
+    << G4endl;
+
+  G4int printed = 0;
+  for ( const auto& line : lines ) {
+    if ( printed++ == fNofLines ) break;
+    const auto& key = line.first;
+    const auto& entry = line.second;
+    G4cout
+      << std::left
+      << " " << std::setw(14) << std::get<0>(key)
+      << std::setw(18) << std::get<1>(key)
+      << std::setw(14) << std::get<2>(key) << std::right
+      << std::setw(14) << entry.steps
+      << std::setw(12) << std::fixed << std::setprecision(3) << entry.seconds
+      << std::setw(8) << std::setprecision(1)
+      << ( total > 0. ? 100.*entry.seconds/total : 0. )
+      << std::setw(10) << std::setprecision(1)
+      << ( entry.steps ? 1.e9*entry.seconds/entry.steps : 0. )
+      << G4endl;
+  }
+  G4cout
+    << " Total: " << totalSteps << " steps, " << std::setprecision(3)
+    << total << " s summed over threads" << G4endl
+    << "----------------------------------------------------------------------"
+    << G4endl;
+  G4cout.unsetf(std::ios::fixed);
+  G4cout << std::setprecision(6);
+
+  report.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
@@ -0,0 +1,152 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file TimeGate.cc
+/// \brief Implementation of the B4c::TimeGate class
+
+#include "TimeGate.hh"
+
+#include "G4AffineTransform.hh"
+#include "G4GenericMessenger.hh"
+#include "G4LogicalVolume.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4Sphere.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Track.hh"
+#include "G4VPhysicalVolume.hh"
+
+#include <algorithm>
+
+namespace B4c
+{
+
+G4ThreadLocal TimeGate* TimeGate::fgInstance = nullptr;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TimeGate* TimeGate::Instance()
+{
+  if ( ! fgInstance ) {
+    fgInstance = new TimeGate();
+  }
+  return fgInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TimeGate::TimeGate()
+  : fWindow(200.*ns)
+{
+  fMessenger = new G4GenericMessenger(this, "/B4/gate/",
+                                      "Acquisition time gate");
+
+  auto& enableCmd = fMessenger->DeclareProperty("enable", fEnabled,
+    "Cull the optical photons which cannot arrive within the gate.");
+  enableCmd.SetParameterName("flag", true);
+  enableCmd.SetDefaultValue("true");
+
+  auto& windowCmd = fMessenger->DeclarePropertyWithUnit("window", "ns",
+    fWindow, "Gate length after the trigger.");
+  windowCmd.SetParameterName("window", false);
+  windowCmd.SetRange("window>0.");
+
+  auto& boundCmd = fMessenger->DeclareProperty("bound", fUseBound,
+    "Also cull the photons which cannot reach AbsoLV in time "
+    "on a straight line.");
+  boundCmd.SetParameterName("flag", true);
+  boundCmd.SetDefaultValue("true");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TimeGate::~TimeGate()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TimeGate::FindTarget()
+{
+  fTargetFound = true;
+
+  auto store = G4PhysicalVolumeStore::GetInstance();
+  auto volume = store->GetVolume("Abso", false);
+  if ( ! volume ) return;
+
+  // Enclosing sphere in the frame of the solid
+  auto solid = volume->GetLogicalVolume()->GetSolid();
+  G4ThreeVector centre;
+  G4double radius;
+  if ( auto sphere = dynamic_cast<const G4Sphere*>(solid) ) {
+    radius = sphere->GetOuterRadius();
+  }
+  else {
+    G4ThreeVector pMin, pMax;
+    solid->BoundingLimits(pMin, pMax);
+    centre = (pMin + pMax) / 2.;
+    radius = (pMax - pMin).mag() / 2.;
+  }
+
+  // Up the placement hierarchy to the world frame
+  G4AffineTransform toGlobal;
+  while ( volume ) {
+    // Frame rotation, as used by the navigation history
+    toGlobal *= G4AffineTransform(volume->GetRotation(),
+                                  volume->GetTranslation());
+    auto mother = volume->GetMotherLogical();
+    if ( ! mother ) break;
+    auto it = std::find_if(store->begin(), store->end(),
+      [mother](const G4VPhysicalVolume* pv) {
+        return pv->GetLogicalVolume() == mother; });
+    volume = ( it != store->end() ) ? *it : nullptr;
+  }
+
+  fTargetCentre = toGlobal.TransformPoint(centre);
+  fTargetRadius = radius;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool TimeGate::IsOutside(const G4Track* track)
+{
+  auto time = track->GetGlobalTime();
+  if ( time > fWindow ) return true;
+  if ( ! fUseBound ) return false;
+
+  if ( ! fTargetFound ) FindTarget();
+  if ( fTargetRadius < 0. ) return false;
+
+  // Earliest possible arrival: straight to the enclosing sphere at c
+  auto distance = std::max(0.,
+    (track->GetPosition() - fTargetCentre).mag() - fTargetRadius);
+  return time + distance / c_light > fWindow;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
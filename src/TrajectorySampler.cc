@@ -0,0 +1,205 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file TrajectorySampler.cc
+/// \brief Implementation of the B4c::TrajectorySampler class
+
+#include "TrajectorySampler.hh"
+
+#include "G4Event.hh"
+#include "G4EventManager.hh"
+#include "G4GenericMessenger.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4Track.hh"
+#include "G4TrackingManager.hh"
+#include "G4TrajectoryContainer.hh"
+#include "G4VTrajectory.hh"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace B4c
+{
+
+G4ThreadLocal TrajectorySampler* TrajectorySampler::fgInstance = nullptr;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TrajectorySampler* TrajectorySampler::Instance()
+{
+  if ( ! fgInstance ) {
+    fgInstance = new TrajectorySampler();
+  }
+  return fgInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TrajectorySampler::TrajectorySampler()
+{
+  fMessenger = new G4GenericMessenger(this, "/B4/trajectory/",
+                                      "Optical photon trajectory sampling");
+
+  auto& photonsCmd = fMessenger->DeclareProperty("photons", fModeName,
+    "Optical photon trajectories to store: all, none, a random fraction "
+    "or a reservoir sample per event.");
+  photonsCmd.SetParameterName("mode", false);
+  photonsCmd.SetCandidates("all none fraction reservoir");
+
+  auto& fractionCmd = fMessenger->DeclareProperty("fraction", fFraction,
+    "Probability to store a photon trajectory in the fraction mode.");
+  fractionCmd.SetParameterName("fraction", false);
+  fractionCmd.SetRange("fraction>=0. && fraction<=1.");
+
+  auto& reservoirCmd = fMessenger->DeclareProperty("reservoir",
+    fReservoirSize,
+    "Maximum number of photon trajectories per event in the reservoir "
+    "mode.");
+  reservoirCmd.SetParameterName("size", false);
+  reservoirCmd.SetRange("size>=0");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TrajectorySampler::~TrajectorySampler()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TrajectorySampler::BeginOfEvent(const G4Event* event)
+{
+  // The mode is frozen for the event
+  if ( fModeName == "none" ) fMode = kNone;
+  else if ( fModeName == "fraction" ) fMode = kFraction;
+  else if ( fModeName == "reservoir" ) fMode = kReservoir;
+  else fMode = kAll;
+
+  fEventID = event->GetEventID();
+  fNofPhotons = 0;
+  fReservoir.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TrajectorySampler::PreTrack(const G4Track* track,
+                                 G4TrackingManager* manager)
+{
+  fRestore = false;
+  fSlot = -1;
+
+  if ( fMode == kAll ) return;
+  if ( manager->GetStoreTrajectory() == 0 ) return;
+  if ( track->GetDefinition() != G4OpticalPhoton::Definition() ) return;
+
+  G4bool keep = false;
+  if ( fMode == kFraction ) {
+    keep = Uniform(track->GetTrackID()) < fFraction;
+  }
+  else if ( fMode == kReservoir && fReservoirSize > 0 ) {
+    // Algorithm R: the n-th photon replaces a random slot with
+    // probability size/n
+    ++fNofPhotons;
+    if ( fNofPhotons <= fReservoirSize ) {
+      keep = true;
+      fSlot = fNofPhotons - 1;
+    }
+    else {
+      auto slot = G4int(Uniform(track->GetTrackID()) * fNofPhotons);
+      if ( slot < fReservoirSize ) {
+        keep = true;
+        fSlot = slot;
+      }
+    }
+  }
+
+  if ( ! keep ) {
+    // The manager creates the trajectory after this call, if requested
+    fSavedStoreMode = manager->GetStoreTrajectory();
+    manager->SetStoreTrajectory(0);
+    fRestore = true;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TrajectorySampler::PostTrack(G4TrackingManager* manager)
+{
+  if ( fRestore ) {
+    manager->SetStoreTrajectory(fSavedStoreMode);
+    fRestore = false;
+  }
+
+  if ( fSlot < 0 ) return;
+
+  // The trajectory is added to the event after this call
+  auto trajectory = manager->GimmeTrajectory();
+  if ( fSlot < G4int(fReservoir.size()) ) {
+    Evict(fReservoir[fSlot]);
+    fReservoir[fSlot] = trajectory;
+  }
+  else {
+    fReservoir.push_back(trajectory);
+  }
+  fSlot = -1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double TrajectorySampler::Uniform(G4int trackID) const
+{
+  // SplitMix64 finaliser of the (event, track) pair
+  auto x = (std::uint64_t(std::uint32_t(fEventID)) << 32)
+           | std::uint32_t(trackID);
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return G4double(x >> 11) * 0x1.0p-53;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TrajectorySampler::Evict(G4VTrajectory* trajectory)
+{
+  if ( ! trajectory ) return;
+
+  auto event = G4EventManager::GetEventManager()->GetNonconstCurrentEvent();
+  auto container = event ? event->GetTrajectoryContainer() : nullptr;
+  if ( ! container ) return;
+
+  // Recent trajectories are at the back
+  auto vector = container->GetVector();
+  auto it = std::find(vector->rbegin(), vector->rend(), trajectory);
+  if ( it == vector->rend() ) return;
+  vector->erase(std::next(it).base());
+  delete trajectory;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+}
@@ -1,8 +1,17 @@
 #include "stepping.hh"
+#include "PhotonCounters.hh"
+#include "PhotonTrackInfo.hh"
+#include "LazyPhotons.hh"
+#include "TimeGate.hh"
+
+#include "G4OpProcessSubType.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4VProcess.hh"
 
 MySteppingAction::MySteppingAction()
 {
-    
+    fProfiler = B4c::StepProfiler::Instance();
+    fLazy = B4c::LazyPhotons::Instance();
 }
 
 MySteppingAction::~MySteppingAction()
@@ -10,6 +19,59 @@ MySteppingAction::~MySteppingAction()
 
 void MySteppingAction::UserSteppingAction(const G4Step *step)
 {
+   if (fProfiler->IsEnabled()) fProfiler->Step(step);
+
+   auto track = step->GetTrack();
+   if (track->GetDefinition() != G4OpticalPhoton::Definition()) {
+     if (fLazy->IsEnabled()) fLazy->RecordStep(step);
+     return;
+   }
+
+   // Path length per material, for the absorption reweighting
+   // (attached by the StackingAction; Attach() only checks it here)
+   auto info = B4c::PhotonTrackInfo::Attach(track);
+   auto counters = B4c::PhotonCounters::Instance();
+   auto preVolume = step->GetPreStepPoint()->GetPhysicalVolume()
+                      ->GetLogicalVolume();
+   auto location = counters->Locate(preVolume);
+   if (location == B4c::PhotonCounters::kQD) {
+     info->AddPathLength(B4c::PhotonTrackInfo::kPathQD, step->GetStepLength());
+   }
+   else if (location == B4c::PhotonCounters::kBottle) {
+     info->AddPathLength(B4c::PhotonTrackInfo::kPathBottle,
+                         step->GetStepLength());
+   }
+   else if (location == B4c::PhotonCounters::kElsewhere) {
+     info->AddPathLength(B4c::PhotonTrackInfo::kPathAir, step->GetStepLength());
+   }
+
+   auto postStep = step->GetPostStepPoint();
+   if (postStep->GetStepStatus() == fWorldBoundary){
+     counters->Add(B4c::PhotonCounters::kEscaped);
+     return;
+   }
+
+   auto process = postStep->GetProcessDefinedStep();
+   if (track->GetTrackStatus() == fStopAndKill && process &&
+       process->GetProcessSubType() == fOpAbsorption){
+     counters->AddAbsorbed(preVolume);
+   }
+   // Absorbed by an optical surface: the black box walls or the stand
+   // (the PMT kills the photons it has accounted in its SD)
+   else if (track->GetTrackStatus() == fStopAndKill && process &&
+            process->GetProcessSubType() == fOpBoundary &&
+            location != B4c::PhotonCounters::kPMT){
+     counters->Add(B4c::PhotonCounters::kAbsorbedWall);
+   }
+
+   // Photons already inside the PMT have been accounted by its SD
+   auto gate = B4c::TimeGate::Instance();
+   if (track->GetTrackStatus() == fAlive && gate->IsEnabled() &&
+       location != B4c::PhotonCounters::kPMT && gate->IsOutside(track)){
+     track->SetTrackStatus(fStopAndKill);
+     counters->Add(B4c::PhotonCounters::kCulled);
+   }
+
    /*G4int pdg = step->GetTrack()->GetParticleDefinition()->GetPDGEncoding();
    double energy = step->GetTrack()->GetKineticEnergy();
    double wavelength = 0.001247/energy;
@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""Check that per-event seeding makes the results thread-count independent.
+
+The macro (which must enable /B4/random/perEventSeeding and write the
+Budget ntuple as csv) is run once per thread count in a scratch
+directory. The per-event rows of the Budget ntuple, collected from all
+the worker files, must be identical for every thread count.
+
+Usage:
+  check_seeding.py --exe exampleB4c --macro seeding.mac --threads 1 4
+"""
+
+import argparse
+import glob
+import os
+import subprocess
+import sys
+import tempfile
+
+
+def read_budget(directory):
+    """Return {event: row} from the Budget csv files of a job."""
+    rows = {}
+    for path in sorted(glob.glob(os.path.join(directory, "*_nt_Budget*.csv"))):
+        columns = []
+        with open(path) as stream:
+            for line in stream:
+                line = line.strip()
+                if line.startswith("#column"):
+                    columns.append(line.split()[-1])
+                elif line and not line.startswith("#"):
+                    values = dict(zip(columns, line.split(",")))
+                    rows[int(values["Event"])] = values
+    return rows
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--exe", required=True)
+    parser.add_argument("--macro", required=True)
+    parser.add_argument("--threads", type=int, nargs="+", default=[1, 4])
+    args = parser.parse_args()
+
+    results = {}
+    for threads in args.threads:
+        with tempfile.TemporaryDirectory(prefix="b4seed_") as scratch:
+            command = [os.path.abspath(args.exe), "-m",
+                       os.path.abspath(args.macro), "-t", str(threads)]
+            job = subprocess.run(command, cwd=scratch, stdout=subprocess.PIPE,
+                                 stderr=subprocess.STDOUT, text=True)
+            if job.returncode != 0:
+                sys.stderr.write(job.stdout[-4000:])
+                sys.exit("exampleB4c -t %d failed with status %d"
+                         % (threads, job.returncode))
+            results[threads] = read_budget(scratch)
+        if not results[threads]:
+            sys.exit("no Budget rows written with -t %d" % threads)
+        print("-t %d: %d events" % (threads, len(results[threads])))
+
+    reference_threads = args.threads[0]
+    reference = results[reference_threads]
+    failed = False
+    for threads, rows in results.items():
+        if rows.keys() != reference.keys():
+            print("FAIL: -t %d processed events %s, -t %d %s"
+                  % (threads, sorted(rows), reference_threads,
+                     sorted(reference)))
+            failed = True
+            continue
+        for event in sorted(rows):
+            if rows[event] != reference[event]:
+                differences = [name for name in rows[event]
+                               if rows[event][name] != reference[event][name]]
+                print("FAIL: event %d differs between -t %d and -t %d in %s"
+                      % (event, reference_threads, threads,
+                         ", ".join(differences)))
+                failed = True
+    if failed:
+        sys.exit(1)
+    print("OK: identical per-event photon budget for -t %s"
+          % " ".join(str(t) for t in args.threads))
+
+
+if __name__ == "__main__":
+    main()
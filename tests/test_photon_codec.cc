@@ -0,0 +1,218 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file test_photon_codec.cc
+/// \brief Round-trip test of the compact photon encoding
+///
+/// Usage: test_photon_codec [scratch.b4p]
+///
+/// Encodes events of random photons with PhotonCodec, writes them to a
+/// scratch .b4p file (test_photon_codec.b4p by default) and reads them
+/// back with PhotonDecoder. The event IDs, photon numbers and creators
+/// must be restored exactly, empty events included, and the wavelengths
+/// and times within kMaxWavelengthError and kMaxTimeError of the encoded
+/// values, those outside the encoded ranges being clamped to the range.
+///
+/// Exit code: 0 if the round trip holds, 1 otherwise.
+
+#include "PhotonCodec.hh"
+
+#include "G4SystemOfUnits.hh"
+#include "globals.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using B4c::CompactPhoton;
+using B4c::PhotonCodec;
+using B4c::PhotonDecoder;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+
+  // Ends of the encoded ranges (wavelengths in nm, see CompactPhoton)
+  const G4double kMinWavelength = PhotonCodec::kWavelengthOffset;
+  const G4double kMaxWavelength
+    = PhotonCodec::kWavelengthOffset + 0xffff * PhotonCodec::kWavelengthStep;
+  const G4double kMaxTime = 0xffffffff * PhotonCodec::kTimeStep;
+
+  // Rounding of the decoded doubles, well below the quantisation errors
+  const G4double kTolerance = 1.e-6;
+
+  G4int nFailures = 0;
+
+  void Fail(G4int eventID, const G4String& what)
+  {
+    if ( ++nFailures <= 10 ) {
+      G4cerr << "Event " << eventID << ": " << what << G4endl;
+    }
+  }
+
+  // Photons in the encoded ranges, and with `outside` of them beyond
+  std::vector<CompactPhoton> MakePhotons(std::mt19937_64& engine,
+                                         G4int nPhotons, G4bool outside)
+  {
+    std::uniform_real_distribution<G4double>
+      wavelength(kMinWavelength, kMaxWavelength),
+      time(0., kMaxTime),
+      beyondWavelength(PhotonCodec::kWavelengthStep, 100.),
+      beyondTime(PhotonCodec::kTimeStep, 1.*ms);
+    std::uniform_int_distribution<G4int> creator(0, 2), side(0, 3);
+
+    std::vector<CompactPhoton> photons(nPhotons);
+    for ( auto& photon : photons ) {
+      photon.wavelength = wavelength(engine);
+      photon.time = time(engine);
+      photon.creator = creator(engine);
+      if ( ! outside ) continue;
+      switch ( side(engine) ) {
+        case 0:
+          photon.wavelength = kMinWavelength - beyondWavelength(engine);
+          break;
+        case 1:
+          photon.wavelength = kMaxWavelength + beyondWavelength(engine);
+          break;
+        case 2:
+          photon.time = - beyondTime(engine);
+          break;
+        default:
+          photon.time = kMaxTime + beyondTime(engine);
+          break;
+      }
+    }
+    return photons;
+  }
+
+  void Compare(G4int eventID, const std::vector<CompactPhoton>& encoded,
+               const std::vector<CompactPhoton>& decoded)
+  {
+    if ( encoded.size() != decoded.size() ) {
+      Fail(eventID, "read " + std::to_string(decoded.size())
+                    + " photons instead of "
+                    + std::to_string(encoded.size()));
+      return;
+    }
+    for ( std::size_t i = 0; i < encoded.size(); ++i ) {
+      auto wavelength = std::min(std::max(encoded[i].wavelength,
+                                          kMinWavelength), kMaxWavelength);
+      auto time = std::min(std::max(encoded[i].time, 0.), kMaxTime);
+      auto photon = std::to_string(i);
+      if ( std::abs(decoded[i].wavelength - wavelength)
+           > PhotonCodec::kMaxWavelengthError * (1. + kTolerance) ) {
+        Fail(eventID, "wavelength of photon " + photon + " is "
+                      + std::to_string(decoded[i].wavelength)
+                      + " nm, encoded "
+                      + std::to_string(encoded[i].wavelength));
+      }
+      if ( std::abs(decoded[i].time - time)
+           > PhotonCodec::kMaxTimeError * (1. + kTolerance) ) {
+        Fail(eventID, "time of photon " + photon + " is "
+                      + std::to_string(decoded[i].time / ns)
+                      + " ns, encoded "
+                      + std::to_string(encoded[i].time / ns));
+      }
+      if ( decoded[i].creator != encoded[i].creator ) {
+        Fail(eventID, "creator of photon " + photon + " is "
+                      + std::to_string(decoded[i].creator));
+      }
+    }
+  }
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc, char** argv)
+{
+  G4String fileName = ( argc > 1 ) ? argv[1] : "test_photon_codec.b4p";
+
+  // Empty events at the start, in between and at the end
+  std::mt19937_64 engine(20240611);
+  std::vector<std::vector<CompactPhoton>> events;
+  events.push_back({});
+  events.push_back(MakePhotons(engine, 1, false));
+  events.push_back(MakePhotons(engine, 50000, false));
+  events.push_back({});
+  events.push_back(MakePhotons(engine, 20000, true));
+  events.push_back(MakePhotons(engine, 1000, false));
+  events.push_back({});
+
+  // EncodeEvent sorts the photons by time: the decoded order
+  std::string buffer(PhotonCodec::GetMagic());
+  for ( std::size_t i = 0; i < events.size(); ++i ) {
+    PhotonCodec::EncodeEvent(G4int(i), events[i], buffer);
+  }
+  {
+    std::ofstream file(fileName, std::ios::binary);
+    file.write(buffer.data(), buffer.size());
+    if ( ! file ) {
+      G4cerr << "Cannot write " << fileName << G4endl;
+      return 1;
+    }
+  }
+
+  PhotonDecoder decoder;
+  if ( ! decoder.Open(fileName) ) {
+    G4cerr << "Cannot read the header of " << fileName << G4endl;
+    std::remove(fileName.c_str());
+    return 1;
+  }
+  G4int eventID = -1;
+  std::vector<CompactPhoton> photons;
+  std::size_t nEvents = 0;
+  while ( decoder.ReadEvent(eventID, photons) ) {
+    if ( nEvents >= events.size() ) {
+      Fail(eventID, "beyond the encoded events");
+      break;
+    }
+    if ( eventID != G4int(nEvents) ) {
+      Fail(eventID, "read instead of " + std::to_string(nEvents));
+    }
+    Compare(eventID, events[nEvents], photons);
+    ++nEvents;
+  }
+  if ( decoder.IsCorrupted() ) Fail(eventID, "truncated record");
+  if ( nEvents != events.size() ) {
+    Fail(eventID, "last of " + std::to_string(nEvents) + " events read,"
+                  + " encoded " + std::to_string(events.size()));
+  }
+  std::remove(fileName.c_str());
+
+  std::size_t nPhotons = 0;
+  for ( const auto& event : events ) nPhotons += event.size();
+  G4cout << nEvents << " events, " << nPhotons << " photons, "
+         << buffer.size() << " bytes: "
+         << ( nFailures ? std::to_string(nFailures) + " failures"
+                        : std::string("round trip OK") ) << G4endl;
+  return nFailures ? 1 : 0;
+}
@@ -0,0 +1,796 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file b4analysis.cc
+/// \brief Multithreaded analysis of the B4c photon output
+///
+/// Usage: b4analysis [-j nThreads] [-o prefix]
+///                   [-n region=nominal.csv] [-a region=alternative.csv]
+///                   [-c region=factor] B4.root [B4_t0.root ...]
+///        b4analysis [-j nThreads] [-o prefix] B4_t0.b4p [B4_t1.b4p ...]
+///
+/// The "B4" photon ntuples of the input files (merged output, worker
+/// shards or checkpoint segments) are streamed in chunks of rows: reader
+/// threads, one G4RootAnalysisReader each, read the files and push the
+/// chunks to a bounded queue, from which the analysis threads fill their
+/// own partial results; these are added at the end. The results are:
+/// - the wavelength and time distributions of the recorded photons,
+/// - the distribution of the number of photons per event,
+/// - the light yield (mean photons per event) with its standard error and
+///   95% confidence interval.
+/// An event is identified by its input file and event ID, as the files of
+/// different runs or seeds reuse the IDs. When the "Budget" ntuple of a
+/// file was written (/B4/budget/writeNtuple true) it provides the photon
+/// count of each event of the file, including the events without any
+/// photon; otherwise only the events of the file with at least one photon
+/// are known.
+///
+/// Each distribution is written to <prefix>_<name>.csv and drawn to
+/// <prefix>_<name>.png; the light yield goes to <prefix>_summary.csv.
+///
+/// Absorption reweighting: the light yield is also computed for another
+/// absorption length spectrum of a region (QD, Bottle or Air) without
+/// rerunning the simulation, from the path lengths per region of each
+/// detected photon (PathQD, PathBottle, PathAir columns). Each photon is
+/// weighted by exp(-sum_r L_r * (c_r/lambda'_r - 1/lambda_r)), with:
+/// - lambda_r the nominal absorption length of the run (-n, required),
+/// - lambda'_r the alternative one (-a, default: the nominal one),
+/// - c_r a factor on the absorption coefficient (-c, default 1), e.g. the
+///   ratio of the CdS fractions for a QD concentration sweep.
+/// The spectra are CSV files of "wavelength_nm,abslength_mm" rows. The
+/// reweighted light yield is added to the summary.
+///
+/// Compact photon files (.b4p, /B4/output/photons compact) can be given
+/// instead of the ROOT files: their records are decoded (see PhotonCodec)
+/// into the same chunks, and give the photon count of every event. They
+/// carry no path lengths, so cannot be reweighted.
+
+#include "PhotonCodec.hh"
+#include "PhotonTrackInfo.hh"
+
+#include "G4RootAnalysisReader.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
+#include "G4UIcommand.hh"
+#include "globals.hh"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+
+  const std::size_t kChunkRows = 1 << 16;
+
+  using B4c::PhotonTrackInfo;
+  const G4int kNofPaths = PhotonTrackInfo::kNofPaths;
+
+  // Rows of the "B4" ntuple of one file; the path lengths only when
+  // reweighting
+  struct Chunk
+  {
+    std::size_t file = 0;  // index of the input file
+    std::vector<G4double> event;
+    std::vector<G4double> wavelength;
+    std::vector<G4double> time;
+    std::array<std::vector<G4double>, kNofPaths> path;
+  };
+
+  // Bounded multi-producer multi-consumer queue of chunks
+  class ChunkQueue
+  {
+    public:
+      explicit ChunkQueue(std::size_t capacity) : fCapacity(capacity) {}
+
+      void Push(Chunk&& chunk)
+      {
+        std::unique_lock<std::mutex> lock(fMutex);
+        fNotFull.wait(lock, [this]() { return fChunks.size() < fCapacity; });
+        fChunks.push_back(std::move(chunk));
+        fNotEmpty.notify_one();
+      }
+
+      G4bool Pop(Chunk& chunk)
+      {
+        std::unique_lock<std::mutex> lock(fMutex);
+        fNotEmpty.wait(lock, [this]() { return fClosed || ! fChunks.empty(); });
+        if ( fChunks.empty() ) return false;
+        chunk = std::move(fChunks.front());
+        fChunks.pop_front();
+        fNotFull.notify_one();
+        return true;
+      }
+
+      void Close()
+      {
+        std::lock_guard<std::mutex> lock(fMutex);
+        fClosed = true;
+        fNotEmpty.notify_all();
+      }
+
+    private:
+      std::size_t fCapacity;
+      std::deque<Chunk> fChunks;
+      G4bool fClosed = false;
+      std::mutex fMutex;
+      std::condition_variable fNotEmpty;
+      std::condition_variable fNotFull;
+  };
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+  struct Histogram
+  {
+    Histogram(G4double xmin, G4double xmax, std::size_t nbins)
+      : min(xmin), max(xmax), bins(nbins, 0) {}
+
+    void Fill(G4double value)
+    {
+      if ( value < min ) { ++underflow; return; }
+      if ( value >= max ) { ++overflow; return; }
+      auto bin = std::size_t((value - min) / (max - min) * bins.size());
+      ++bins[std::min(bin, bins.size() - 1)];
+    }
+
+    void Add(const Histogram& other)
+    {
+      for ( std::size_t i = 0; i < bins.size(); ++i ) bins[i] += other.bins[i];
+      underflow += other.underflow;
+      overflow += other.overflow;
+    }
+
+    G4double min;
+    G4double max;
+    std::vector<G4long> bins;
+    G4long underflow = 0;
+    G4long overflow = 0;
+  };
+
+  // Input file index and event ID
+  using EventKey = std::pair<std::size_t, G4long>;
+
+  struct EventKeyHash
+  {
+    std::size_t operator()(const EventKey& key) const
+    {
+      return std::hash<G4long>()(key.second)
+           ^ (std::hash<std::size_t>()(key.first) << 1);
+    }
+  };
+
+  // Partial result of one analysis thread
+  struct Result
+  {
+    Histogram wavelength{200., 800., 600};  // nm
+    Histogram time{0., 200., 400};          // ns
+    std::unordered_map<EventKey, G4long, EventKeyHash> photonsPerEvent;
+    G4long photons = 0;
+    std::unordered_map<EventKey, G4double, EventKeyHash> weightsPerEvent;
+    G4double weightedPhotons = 0.;
+
+    void Add(const Result& other)
+    {
+      wavelength.Add(other.wavelength);
+      time.Add(other.time);
+      for ( const auto& entry : other.photonsPerEvent ) {
+        photonsPerEvent[entry.first] += entry.second;
+      }
+      photons += other.photons;
+      for ( const auto& entry : other.weightsPerEvent ) {
+        weightsPerEvent[entry.first] += entry.second;
+      }
+      weightedPhotons += other.weightedPhotons;
+    }
+  };
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+  // Absorption length versus wavelength, linearly interpolated and
+  // constant beyond the first and last points
+  struct AbsorptionSpectrum
+  {
+    std::vector<G4double> wavelength;  // nm, increasing
+    std::vector<G4double> length;      // mm
+
+    G4bool Load(const G4String& fileName)
+    {
+      std::ifstream file(fileName);
+      if ( ! file ) return false;
+      std::vector<std::pair<G4double, G4double>> points;
+      std::string line;
+      while ( std::getline(file, line) ) {
+        std::istringstream row(line);
+        G4double x = 0., y = 0.;
+        char separator = 0;
+        if ( row >> x >> separator >> y && separator == ',' && y > 0. ) {
+          points.emplace_back(x, y);
+        }
+      }
+      std::sort(points.begin(), points.end());
+      for ( const auto& point : points ) {
+        wavelength.push_back(point.first);
+        length.push_back(point.second);
+      }
+      return ! points.empty();
+    }
+
+    G4double GetInverseLength(G4double value) const
+    {
+      if ( value <= wavelength.front() ) return 1./length.front();
+      if ( value >= wavelength.back() ) return 1./length.back();
+      auto i = std::size_t(
+        std::upper_bound(wavelength.begin(), wavelength.end(), value)
+        - wavelength.begin());
+      auto f = (value - wavelength[i-1])/(wavelength[i] - wavelength[i-1]);
+      return 1./(length[i-1] + f*(length[i] - length[i-1]));
+    }
+  };
+
+  // Detection weights for alternative absorption spectra per region
+  struct Reweighting
+  {
+    std::array<AbsorptionSpectrum, kNofPaths> nominal;
+    std::array<AbsorptionSpectrum, kNofPaths> alternative;
+    std::array<G4double, kNofPaths> factor = {1., 1., 1.};
+    std::array<G4bool, kNofPaths> active = {};
+
+    G4bool IsEnabled() const
+    {
+      return std::find(active.begin(), active.end(), true) != active.end();
+    }
+
+    G4double GetWeight(G4double wavelength, const Chunk& chunk,
+                       std::size_t row) const
+    {
+      G4double exponent = 0.;
+      for ( G4int r = 0; r < kNofPaths; ++r ) {
+        if ( ! active[r] ) continue;
+        auto mu = nominal[r].GetInverseLength(wavelength);
+        auto muAlternative = alternative[r].wavelength.empty() ? mu
+                           : alternative[r].GetInverseLength(wavelength);
+        exponent += chunk.path[r][row] * (factor[r]*muAlternative - mu);
+      }
+      return std::exp(-exponent);
+    }
+  };
+
+  // Region index of "QD", "Bottle" or "Air", -1 if unknown
+  G4int GetRegion(const G4String& name)
+  {
+    for ( G4int r = 0; r < kNofPaths; ++r ) {
+      auto path = PhotonTrackInfo::GetName(PhotonTrackInfo::Path(r));
+      if ( "Path" + name == path ) return r;
+    }
+    return -1;
+  }
+
+  void PrintUsage() {
+    G4cerr << " Usage: " << G4endl;
+    G4cerr << " b4analysis [-j nThreads] [-o prefix]" << G4endl
+           << "            [-n region=nominal.csv] [-a region=alternative.csv]"
+           << G4endl
+           << "            [-c region=factor] input.root ..." << G4endl
+           << " region: QD, Bottle or Air" << G4endl;
+  }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+  // Streams the photon rows of a file to the queue; returns false if the
+  // file has no "Budget" ntuple, else true with its per-event photon
+  // counts
+  G4bool ReadFile(G4RootAnalysisReader* reader, const G4String& fileName,
+                  std::size_t file, ChunkQueue& queue, G4bool withPaths,
+                  std::vector<G4long>& counts)
+  {
+    auto id = reader->GetNtuple("B4", fileName);
+    if ( id >= 0 ) {
+      G4double event = 0., wavelength = 0., time = 0.;
+      std::array<G4double, kNofPaths> path = {};
+      reader->SetNtupleDColumn(id, "Event", event);
+      reader->SetNtupleDColumn(id, "Wavelength", wavelength);
+      reader->SetNtupleDColumn(id, "Time", time);
+      if ( withPaths ) {
+        for ( G4int r = 0; r < kNofPaths; ++r ) {
+          reader->SetNtupleDColumn(id,
+            PhotonTrackInfo::GetName(PhotonTrackInfo::Path(r)), path[r]);
+        }
+      }
+      Chunk chunk;
+      chunk.file = file;
+      while ( reader->GetNtupleRow(id) ) {
+        chunk.event.push_back(event);
+        chunk.wavelength.push_back(wavelength);
+        chunk.time.push_back(time);
+        if ( withPaths ) {
+          for ( G4int r = 0; r < kNofPaths; ++r ) {
+            chunk.path[r].push_back(path[r]);
+          }
+        }
+        if ( chunk.event.size() == kChunkRows ) {
+          queue.Push(std::move(chunk));
+          chunk = Chunk();
+          chunk.file = file;
+        }
+      }
+      if ( ! chunk.event.empty() ) queue.Push(std::move(chunk));
+    }
+
+    auto budgetId = reader->GetNtuple("Budget", fileName);
+    if ( budgetId < 0 ) return false;
+    G4int value = 0;
+    reader->SetNtupleIColumn(budgetId, "Recorded", value);
+    while ( reader->GetNtupleRow(budgetId) ) counts.push_back(value);
+    return true;
+  }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+  G4bool IsCompactFile(const G4String& fileName)
+  {
+    return fileName.size() > 4
+        && fileName.compare(fileName.size() - 4, 4, ".b4p") == 0;
+  }
+
+  // Decodes the photons of a compact file to the queue and gives the
+  // number of photons of each event; false if the file is not readable
+  G4bool ReadCompactFile(const G4String& fileName, std::size_t file,
+                         ChunkQueue& queue, std::vector<G4long>& counts)
+  {
+    B4c::PhotonDecoder decoder;
+    if ( ! decoder.Open(fileName) ) {
+      G4cerr << "b4analysis: " << fileName << " is not a .b4p file"
+             << G4endl;
+      return false;
+    }
+
+    G4int eventID = 0;
+    std::vector<B4c::CompactPhoton> photons;
+    Chunk chunk;
+    chunk.file = file;
+    while ( decoder.ReadEvent(eventID, photons) ) {
+      counts.push_back(G4long(photons.size()));
+      for ( const auto& photon : photons ) {
+        chunk.event.push_back(eventID);
+        chunk.wavelength.push_back(photon.wavelength);
+        chunk.time.push_back(photon.time);
+        if ( chunk.event.size() == kChunkRows ) {
+          queue.Push(std::move(chunk));
+          chunk = Chunk();
+          chunk.file = file;
+        }
+      }
+    }
+    if ( ! chunk.event.empty() ) queue.Push(std::move(chunk));
+    if ( decoder.IsCorrupted() ) {
+      G4cerr << "b4analysis: " << fileName << " is truncated after "
+             << counts.size() << " events" << G4endl;
+    }
+    return true;
+  }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+  void Analyse(const Chunk& chunk, const Reweighting& reweighting,
+               Result& result)
+  {
+    for ( std::size_t i = 0; i < chunk.event.size(); ++i ) {
+      result.wavelength.Fill(chunk.wavelength[i]);
+      result.time.Fill(chunk.time[i]/ns);
+      ++result.photonsPerEvent[EventKey(chunk.file, G4long(chunk.event[i]))];
+    }
+    result.photons += G4long(chunk.event.size());
+
+    if ( ! reweighting.IsEnabled() ) return;
+    for ( std::size_t i = 0; i < chunk.event.size(); ++i ) {
+      auto weight = reweighting.GetWeight(chunk.wavelength[i], chunk, i);
+      result.weightsPerEvent[EventKey(chunk.file, G4long(chunk.event[i]))]
+        += weight;
+      result.weightedPhotons += weight;
+    }
+  }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+  // Minimal PNG encoder: 8-bit RGB, uncompressed (stored) deflate blocks
+
+  std::uint32_t Crc32(const std::uint8_t* data, std::size_t size,
+                      std::uint32_t crc = 0)
+  {
+    static std::uint32_t table[256];
+    static G4bool initialised = false;
+    if ( ! initialised ) {
+      for ( std::uint32_t n = 0; n < 256; ++n ) {
+        std::uint32_t c = n;
+        for ( G4int k = 0; k < 8; ++k ) {
+          c = ( c & 1 ) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        table[n] = c;
+      }
+      initialised = true;
+    }
+    crc = ~crc;
+    for ( std::size_t i = 0; i < size; ++i ) {
+      crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+  }
+
+  void PutUint32(std::vector<std::uint8_t>& out, std::uint32_t value)
+  {
+    for ( G4int shift = 24; shift >= 0; shift -= 8 ) {
+      out.push_back(std::uint8_t(value >> shift));
+    }
+  }
+
+  void WriteChunk(std::ofstream& file, const char* type,
+                  const std::vector<std::uint8_t>& data)
+  {
+    std::vector<std::uint8_t> chunk;
+    PutUint32(chunk, std::uint32_t(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    PutUint32(chunk, Crc32(chunk.data() + 4, chunk.size() - 4));
+    file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+  }
+
+  void WritePng(const G4String& fileName, G4int width, G4int height,
+                const std::vector<std::uint8_t>& rgb)
+  {
+    // Filter byte 0 (none) in front of each scanline
+    std::vector<std::uint8_t> raw;
+    for ( G4int y = 0; y < height; ++y ) {
+      raw.push_back(0);
+      raw.insert(raw.end(), rgb.begin() + y*width*3,
+                 rgb.begin() + (y+1)*width*3);
+    }
+
+    // zlib stream of stored blocks
+    std::vector<std::uint8_t> zlib = {0x78, 0x01};
+    std::size_t offset = 0;
+    do {
+      auto size = std::min<std::size_t>(raw.size() - offset, 65535);
+      G4bool last = ( offset + size == raw.size() );
+      zlib.push_back(last ? 1 : 0);
+      zlib.push_back(std::uint8_t(size));
+      zlib.push_back(std::uint8_t(size >> 8));
+      zlib.push_back(std::uint8_t(~size));
+      zlib.push_back(std::uint8_t(~size >> 8));
+      zlib.insert(zlib.end(),
+                  raw.begin() + offset, raw.begin() + offset + size);
+      offset += size;
+    } while ( offset < raw.size() );
+    std::uint32_t a = 1, b = 0;
+    for ( auto byte : raw ) {
+      a = (a + byte) % 65521;
+      b = (b + a) % 65521;
+    }
+    PutUint32(zlib, (b << 16) | a);
+
+    std::vector<std::uint8_t> header;
+    PutUint32(header, std::uint32_t(width));
+    PutUint32(header, std::uint32_t(height));
+    header.insert(header.end(), {8, 2, 0, 0, 0});  // 8 bit RGB
+
+    std::ofstream file(fileName, std::ios::binary);
+    const std::uint8_t signature[]
+      = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+    WriteChunk(file, "IHDR", header);
+    WriteChunk(file, "IDAT", zlib);
+    WriteChunk(file, "IEND", {});
+  }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+  // Bar chart of a histogram with a frame and ten-division grid; the axis
+  // ranges are those of the CSV file written alongside
+  void PlotHistogram(const G4String& fileName, const Histogram& histogram)
+  {
+    const G4int width = 800, height = 500, margin = 40;
+    std::vector<std::uint8_t> rgb(width*height*3, 255);
+    auto pixel = [&](G4int x, G4int y, std::uint8_t r, std::uint8_t g,
+                     std::uint8_t b) {
+      if ( x < 0 || x >= width || y < 0 || y >= height ) return;
+      auto p = &rgb[(y*width + x)*3];
+      p[0] = r; p[1] = g; p[2] = b;
+    };
+
+    const G4int plotWidth = width - 2*margin, plotHeight = height - 2*margin;
+    for ( G4int i = 0; i <= 10; ++i ) {
+      auto x = margin + i*plotWidth/10, y = margin + i*plotHeight/10;
+      for ( G4int k = margin; k <= height - margin; ++k ) {
+        pixel(x, k, 225, 225, 225);
+      }
+      for ( G4int k = margin; k <= width - margin; ++k ) {
+        pixel(k, y, 225, 225, 225);
+      }
+    }
+
+    auto maxContent = *std::max_element(histogram.bins.begin(),
+                                        histogram.bins.end());
+    auto nbins = G4int(histogram.bins.size());
+    if ( maxContent > 0 ) {
+      for ( G4int i = 0; i < nbins; ++i ) {
+        auto x0 = margin + i*plotWidth/nbins;
+        auto x1 = std::max(x0 + 1, margin + (i+1)*plotWidth/nbins);
+        auto top = height - margin
+          - G4int(G4double(histogram.bins[i])/maxContent*plotHeight);
+        for ( G4int x = x0; x < x1; ++x ) {
+          for ( G4int y = top; y < height - margin; ++y ) {
+            pixel(x, y, 40, 90, 180);
+          }
+        }
+      }
+    }
+
+    for ( G4int k = margin; k <= width - margin; ++k ) {
+      pixel(k, margin, 0, 0, 0);
+      pixel(k, height - margin, 0, 0, 0);
+    }
+    for ( G4int k = margin; k <= height - margin; ++k ) {
+      pixel(margin, k, 0, 0, 0);
+      pixel(width - margin, k, 0, 0, 0);
+    }
+
+    WritePng(fileName, width, height, rgb);
+  }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+  void WriteHistogram(const G4String& prefix, const G4String& name,
+                      const Histogram& histogram)
+  {
+    std::ofstream csv(prefix + "_" + name + ".csv");
+    csv << "low,high,count,error\n";
+    auto width = (histogram.max - histogram.min)/histogram.bins.size();
+    for ( std::size_t i = 0; i < histogram.bins.size(); ++i ) {
+      csv << histogram.min + i*width << "," << histogram.min + (i+1)*width
+          << "," << histogram.bins[i]
+          << "," << std::sqrt(G4double(histogram.bins[i])) << "\n";
+    }
+    csv << "# underflow " << histogram.underflow
+        << ", overflow " << histogram.overflow << "\n";
+    PlotHistogram(prefix + "_" + name + ".png", histogram);
+  }
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+  // Evaluate arguments
+  //
+  G4String prefix = "B4_analysis";
+  G4int nThreads = G4int(std::thread::hardware_concurrency());
+  std::vector<G4String> fileNames;
+  Reweighting reweighting;
+  for ( G4int i=1; i<argc; ++i ) {
+    G4String arg = argv[i];
+    if ( arg == "-o" && i+1 < argc ) prefix = argv[++i];
+    else if ( arg == "-j" && i+1 < argc ) {
+      nThreads = G4UIcommand::ConvertToInt(argv[++i]);
+    }
+    else if ( ( arg == "-n" || arg == "-a" || arg == "-c" ) && i+1 < argc ) {
+      G4String option = argv[++i];
+      auto separator = option.find('=');
+      auto region = ( separator == std::string::npos ) ? -1
+                  : GetRegion(option.substr(0, separator));
+      if ( region < 0 ) {
+        PrintUsage();
+        return 1;
+      }
+      auto value = option.substr(separator + 1);
+      G4bool ok = true;
+      if ( arg == "-n" ) {
+        ok = reweighting.nominal[region].Load(value);
+      }
+      else if ( arg == "-a" ) {
+        ok = reweighting.alternative[region].Load(value);
+        reweighting.active[region] = true;
+      }
+      else {
+        reweighting.factor[region] = G4UIcommand::ConvertToDouble(value);
+        reweighting.active[region] = true;
+      }
+      if ( ! ok ) {
+        G4cerr << "b4analysis: cannot read the spectrum " << value << G4endl;
+        return 1;
+      }
+    }
+    else if ( arg.size() > 0 && arg[0] == '-' ) {
+      PrintUsage();
+      return 1;
+    }
+    else {
+      fileNames.push_back(arg);
+    }
+  }
+  if ( fileNames.empty() ) {
+    PrintUsage();
+    return 1;
+  }
+  for ( G4int r = 0; r < kNofPaths; ++r ) {
+    if ( reweighting.active[r] && reweighting.nominal[r].wavelength.empty() ) {
+      G4cerr << "b4analysis: the reweighting of a region requires its "
+             << "nominal spectrum (-n)" << G4endl;
+      return 1;
+    }
+  }
+  if ( reweighting.IsEnabled()
+       && std::any_of(fileNames.begin(), fileNames.end(), IsCompactFile) ) {
+    G4cerr << "b4analysis: the .b4p files have no path lengths to "
+           << "reweight" << G4endl;
+    return 1;
+  }
+  nThreads = std::max(1, nThreads);
+  auto nReaders = std::min(nThreads, G4int(fileNames.size()));
+
+  // Readers: one file at a time each, with a thread-local reader instance
+  //
+  G4RootAnalysisReader::Instance(); // master instance
+  ChunkQueue queue(2*std::size_t(nThreads));
+  std::atomic<std::size_t> nextFile(0);
+  std::atomic<G4int> activeReaders(nReaders);
+  // Photons per event of each file, from its Budget ntuple or .b4p records
+  std::vector<std::vector<G4long>> budgets(fileNames.size());
+  std::vector<char> hasBudget(fileNames.size(), false);  // one per reader
+  std::vector<std::thread> readers;
+  for ( G4int t = 0; t < nReaders; ++t ) {
+    readers.emplace_back([&, t]() {
+      G4Threading::G4SetThreadId(t);
+      auto reader = G4RootAnalysisReader::Instance();
+      reader->SetVerboseLevel(0);
+      for ( auto i = nextFile++; i < fileNames.size(); i = nextFile++ ) {
+        hasBudget[i] = IsCompactFile(fileNames[i])
+          ? ReadCompactFile(fileNames[i], i, queue, budgets[i])
+          : ReadFile(reader, fileNames[i], i, queue, reweighting.IsEnabled(),
+                     budgets[i]);
+      }
+      if ( --activeReaders == 0 ) queue.Close();
+    });
+  }
+
+  // Analysis threads
+  //
+  std::vector<Result> results(nThreads);
+  std::vector<std::thread> workers;
+  for ( G4int t = 0; t < nThreads; ++t ) {
+    workers.emplace_back([&queue, &reweighting, &results, t]() {
+      Chunk chunk;
+      while ( queue.Pop(chunk) ) Analyse(chunk, reweighting, results[t]);
+    });
+  }
+  for ( auto& reader : readers ) reader.join();
+  for ( auto& worker : workers ) worker.join();
+
+  Result result;
+  for ( const auto& partial : results ) result.Add(partial);
+
+  // Photons per event, file by file: from the budget if available
+  // (includes the events without photons), otherwise from the photon rows
+  //
+  std::vector<G4long> counts;
+  std::size_t nofFilesWithoutBudget = 0;
+  for ( std::size_t i = 0; i < fileNames.size(); ++i ) {
+    if ( hasBudget[i] ) {
+      counts.insert(counts.end(), budgets[i].begin(), budgets[i].end());
+    }
+    else {
+      ++nofFilesWithoutBudget;
+    }
+  }
+  if ( nofFilesWithoutBudget > 0 ) {
+    for ( const auto& entry : result.photonsPerEvent ) {
+      if ( ! hasBudget[entry.first.first] ) counts.push_back(entry.second);
+    }
+  }
+
+  G4double mean = 0., variance = 0.;
+  for ( auto count : counts ) mean += count;
+  if ( ! counts.empty() ) mean /= counts.size();
+  for ( auto count : counts ) variance += (count - mean)*(count - mean);
+  if ( counts.size() > 1 ) variance /= counts.size() - 1;
+  auto error = counts.empty() ? 0. : std::sqrt(variance/counts.size());
+
+  G4long maxCount = counts.empty() ? 1
+                  : *std::max_element(counts.begin(), counts.end()) + 1;
+  Histogram perEvent(0., G4double(maxCount),
+                     std::min<std::size_t>(100, std::size_t(maxCount)));
+  for ( auto count : counts ) perEvent.Fill(G4double(count));
+
+  // Output
+  //
+  WriteHistogram(prefix, "wavelength", result.wavelength);
+  WriteHistogram(prefix, "time", result.time);
+  WriteHistogram(prefix, "photons_per_event", perEvent);
+
+  std::ofstream summary(prefix + "_summary.csv");
+  summary << "quantity,value,error,ci95_low,ci95_high\n"
+          << "photons," << result.photons << ",,,\n"
+          << "events," << counts.size() << ",,,\n"
+          << "light_yield," << mean << "," << error << ","
+          << mean - 1.96*error << "," << mean + 1.96*error << "\n"
+          << "light_yield_rms," << std::sqrt(variance) << ",,,\n";
+
+  // Reweighted light yield, over the same events (those without any
+  // weighted photon count zero)
+  if ( reweighting.IsEnabled() ) {
+    std::vector<G4double> weights;
+    for ( const auto& entry : result.weightsPerEvent ) {
+      weights.push_back(entry.second);
+    }
+    weights.resize(std::max(weights.size(), counts.size()), 0.);
+    G4double weightedMean = 0., weightedVariance = 0.;
+    for ( auto weight : weights ) weightedMean += weight;
+    if ( ! weights.empty() ) weightedMean /= weights.size();
+    for ( auto weight : weights ) {
+      weightedVariance += (weight - weightedMean)*(weight - weightedMean);
+    }
+    if ( weights.size() > 1 ) weightedVariance /= weights.size() - 1;
+    auto weightedError = weights.empty() ? 0.
+                       : std::sqrt(weightedVariance/weights.size());
+    summary << "reweighted_photons," << result.weightedPhotons << ",,,\n"
+            << "reweighted_light_yield," << weightedMean << ","
+            << weightedError << "," << weightedMean - 1.96*weightedError
+            << "," << weightedMean + 1.96*weightedError << "\n";
+    G4cout
+      << "b4analysis: reweighted light yield " << weightedMean << " +- "
+      << weightedError << " photons/event" << G4endl;
+  }
+
+  G4cout
+    << "b4analysis: " << result.photons << " photons in " << counts.size()
+    << " events" << G4endl;
+  if ( nofFilesWithoutBudget > 0 ) {
+    G4cout
+      << "b4analysis: " << nofFilesWithoutBudget << " of "
+      << fileNames.size() << " files have no Budget ntuple: only their "
+      << "events with photons are counted" << G4endl;
+  }
+  G4cout
+    << "b4analysis: light yield " << mean << " +- " << error
+    << " photons/event (95% CL " << mean - 1.96*error << " - "
+    << mean + 1.96*error << ")" << G4endl
+    << "b4analysis: results written to " << prefix << "_*.csv/png" << G4endl;
+  return 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,143 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file b4decode.cc
+/// \brief Decoder of the compact B4c photon files
+///
+/// Usage: b4decode [-o photons.csv] B4.b4p [B4_t1.b4p ...]
+///
+/// Writes the photons of the .b4p files (/B4/output/photons compact or
+/// both) as "event,wavelength_nm,time_ns,creator" CSV rows, to the given
+/// file or to the standard output, in file, event and time order. The
+/// times are relative to the event time; the creator is 0 (other),
+/// 1 (scintillation) or 2 (Cerenkov). A summary with the size per photon
+/// and the maximum quantisation errors (see PhotonCodec) is printed on the
+/// standard error.
+///
+/// Exit code: 0 on success, 1 on usage errors or unreadable or truncated
+/// files.
+
+#include "PhotonCodec.hh"
+
+#include "G4SystemOfUnits.hh"
+#include "globals.hh"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+
+  void PrintUsage() {
+    G4cerr << " Usage: " << G4endl;
+    G4cerr << " b4decode [-o photons.csv] input.b4p ..." << G4endl;
+  }
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+  // Evaluate arguments
+  //
+  G4String outputName;
+  std::vector<G4String> fileNames;
+  for ( G4int i=1; i<argc; ++i ) {
+    G4String arg = argv[i];
+    if ( arg == "-o" && i+1 < argc ) outputName = argv[++i];
+    else if ( arg.size() > 0 && arg[0] == '-' ) {
+      PrintUsage();
+      return 1;
+    }
+    else {
+      fileNames.push_back(arg);
+    }
+  }
+  if ( fileNames.empty() ) {
+    PrintUsage();
+    return 1;
+  }
+
+  std::ofstream outputFile;
+  if ( ! outputName.empty() ) {
+    outputFile.open(outputName);
+    if ( ! outputFile ) {
+      G4cerr << "b4decode: cannot write " << outputName << G4endl;
+      return 1;
+    }
+  }
+  std::ostream& output = outputName.empty() ? std::cout : outputFile;
+  output << "event,wavelength_nm,time_ns,creator\n"
+         << std::setprecision(10);
+
+  // Decode
+  //
+  G4bool failed = false;
+  G4long nofEvents = 0, nofPhotons = 0, nofBytes = 0;
+  for ( const auto& fileName : fileNames ) {
+    B4c::PhotonDecoder decoder;
+    if ( ! decoder.Open(fileName) ) {
+      G4cerr << "b4decode: " << fileName << " is not a .b4p file" << G4endl;
+      failed = true;
+      continue;
+    }
+    G4int eventID = 0;
+    std::vector<B4c::CompactPhoton> photons;
+    while ( decoder.ReadEvent(eventID, photons) ) {
+      ++nofEvents;
+      nofPhotons += G4long(photons.size());
+      for ( const auto& photon : photons ) {
+        output << eventID << "," << photon.wavelength << ","
+               << photon.time/ns << "," << photon.creator << "\n";
+      }
+    }
+    if ( decoder.IsCorrupted() ) {
+      G4cerr << "b4decode: " << fileName << " is truncated" << G4endl;
+      failed = true;
+    }
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    nofBytes += G4long(file.tellg());
+  }
+
+  G4cerr
+    << "b4decode: " << nofPhotons << " photons in " << nofEvents
+    << " events, " << nofBytes << " bytes";
+  if ( nofPhotons > 0 ) {
+    G4cerr << " (" << G4double(nofBytes)/nofPhotons << " bytes/photon)";
+  }
+  G4cerr
+    << G4endl
+    << "b4decode: quantisation error at most "
+    << B4c::PhotonCodec::kMaxWavelengthError << " nm, "
+    << B4c::PhotonCodec::kMaxTimeError/picosecond << " ps" << G4endl;
+  return failed ? 1 : 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
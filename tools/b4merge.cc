@@ -0,0 +1,356 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file b4merge.cc
+/// \brief Offline merger of the per-worker B4c output shards
+///
+/// Usage: b4merge -o merged.root [-j nThreads] B4.root B4_t0.root ...
+///
+/// The input files are read in parallel, one G4RootAnalysisReader per
+/// reader thread, and written to the output file in the order given on
+/// the command line by the main thread. A reader starts an input only
+/// when fewer than nThreads inputs are read ahead of the one being
+/// written, which bounds the memory to nThreads inputs. Histograms are
+/// summed, ntuple rows are concatenated. For each input the number of
+/// rows of the "B4" photon ntuple is checked against the sum of the
+/// "Recorded" column of the "Budget" ntuple (filled with
+/// /B4/budget/writeNtuple true), unless the input has no photon ntuple
+/// (/B4/output/photons compact). An input that cannot be opened, or holds
+/// none of the histograms and ntuples of the output schema, is a read
+/// error and is not merged.
+///
+/// Exit code: 0 on success, 1 on usage or read errors, 2 if the row
+/// counts do not match the photon budget.
+
+#include "OutputSchema.hh"
+
+#include "G4AnalysisManager.hh"
+#include "G4RootAnalysisReader.hh"
+#include "G4Threading.hh"
+#include "G4UIcommand.hh"
+#include "globals.hh"
+
+#include "tools/histo/h1d"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+
+  // Content of one ntuple of one input, stored by column
+  struct NtupleData
+  {
+    std::vector<std::vector<G4double>> dColumns;
+    std::vector<std::vector<G4int>> iColumns;
+    std::size_t nofRows = 0;
+    G4bool found = false;
+  };
+
+  struct Shard
+  {
+    G4String fileName;
+    std::vector<tools::histo::h1d> histograms; // same order as GetH1Schemas
+    std::vector<G4bool> hasHistogram;
+    std::vector<NtupleData> ntuples; // same order as GetNtupleSchemas
+    G4bool readable = false;
+    G4bool ready = false;
+  };
+
+  void PrintUsage() {
+    G4cerr << " Usage: " << G4endl;
+    G4cerr << " b4merge -o output.root [-j nThreads] input.root ..." << G4endl;
+    G4cerr << "   e.g. b4merge -o B4_merged.root B4.root B4_t*.root" << G4endl;
+  }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+  // Returns false if the file cannot be opened or holds none of the
+  // histograms and ntuples of the schema
+  G4bool ReadShard(G4RootAnalysisReader* reader, Shard& shard)
+  {
+    const auto& h1Schemas = B4c::GetH1Schemas();
+    const auto& ntupleSchemas = B4c::GetNtupleSchemas();
+    shard.histograms.assign(h1Schemas.size(),
+                            tools::histo::h1d("", 1, 0., 1.));
+    shard.hasHistogram.assign(h1Schemas.size(), false);
+    shard.ntuples.resize(ntupleSchemas.size());
+    if ( ! std::ifstream(shard.fileName) ) return false;
+
+    G4bool found = false;
+    for ( std::size_t i = 0; i < h1Schemas.size(); ++i ) {
+      auto id = reader->ReadH1(h1Schemas[i].name, shard.fileName);
+      auto h1 = ( id >= 0 ) ? reader->GetH1(id) : nullptr;
+      if ( h1 ) {
+        shard.histograms[i] = *h1;
+        shard.hasHistogram[i] = true;
+        found = true;
+      }
+    }
+
+    for ( std::size_t i = 0; i < ntupleSchemas.size(); ++i ) {
+      const auto& columns = ntupleSchemas[i].columns;
+      auto& data = shard.ntuples[i];
+      data.dColumns.resize(columns.size());
+      data.iColumns.resize(columns.size());
+
+      auto id = reader->GetNtuple(ntupleSchemas[i].name, shard.fileName);
+      if ( id < 0 ) continue;
+      data.found = true;
+      found = true;
+
+      // The reader fills the bound variables on each GetNtupleRow() call
+      std::vector<G4double> dValues(columns.size(), 0.);
+      std::vector<G4int> iValues(columns.size(), 0);
+      for ( std::size_t j = 0; j < columns.size(); ++j ) {
+        if ( columns[j].type == 'I' ) {
+          reader->SetNtupleIColumn(id, columns[j].name, iValues[j]);
+        }
+        else {
+          reader->SetNtupleDColumn(id, columns[j].name, dValues[j]);
+        }
+      }
+      while ( reader->GetNtupleRow(id) ) {
+        for ( std::size_t j = 0; j < columns.size(); ++j ) {
+          if ( columns[j].type == 'I' ) {
+            data.iColumns[j].push_back(iValues[j]);
+          }
+          else {
+            data.dColumns[j].push_back(dValues[j]);
+          }
+        }
+        ++data.nofRows;
+      }
+    }
+    return found;
+  }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+  void WriteShard(const Shard& shard)
+  {
+    auto analysisManager = G4AnalysisManager::Instance();
+
+    for ( std::size_t i = 0; i < shard.histograms.size(); ++i ) {
+      if ( shard.hasHistogram[i] ) {
+        analysisManager->GetH1(G4int(i))->add(shard.histograms[i]);
+      }
+    }
+
+    const auto& ntupleSchemas = B4c::GetNtupleSchemas();
+    for ( std::size_t i = 0; i < ntupleSchemas.size(); ++i ) {
+      const auto& columns = ntupleSchemas[i].columns;
+      const auto& data = shard.ntuples[i];
+      for ( std::size_t row = 0; row < data.nofRows; ++row ) {
+        for ( std::size_t j = 0; j < columns.size(); ++j ) {
+          if ( columns[j].type == 'I' ) {
+            analysisManager->FillNtupleIColumn(G4int(i), G4int(j),
+                                               data.iColumns[j][row]);
+          }
+          else {
+            analysisManager->FillNtupleDColumn(G4int(i), G4int(j),
+                                               data.dColumns[j][row]);
+          }
+        }
+        analysisManager->AddNtupleRow(G4int(i));
+      }
+    }
+  }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+  // Returns the sum of the "Recorded" budget counter, or -1 if the input
+  // has no budget rows
+  G4long GetRecordedPhotons(const Shard& shard)
+  {
+    const auto& ntupleSchemas = B4c::GetNtupleSchemas();
+    for ( std::size_t i = 0; i < ntupleSchemas.size(); ++i ) {
+      if ( ntupleSchemas[i].name != "Budget" ) continue;
+      const auto& data = shard.ntuples[i];
+      if ( data.nofRows == 0 ) return -1;
+      const auto& columns = ntupleSchemas[i].columns;
+      for ( std::size_t j = 0; j < columns.size(); ++j ) {
+        if ( columns[j].name != "Recorded" ) continue;
+        G4long sum = 0;
+        for ( auto value : data.iColumns[j] ) sum += value;
+        return sum;
+      }
+    }
+    return -1;
+  }
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+  // Evaluate arguments
+  //
+  G4String outputName;
+  G4int nThreads = G4int(std::thread::hardware_concurrency());
+  std::vector<Shard> shards;
+  for ( G4int i=1; i<argc; ++i ) {
+    G4String arg = argv[i];
+    if ( arg == "-o" && i+1 < argc ) outputName = argv[++i];
+    else if ( arg == "-j" && i+1 < argc ) {
+      nThreads = G4UIcommand::ConvertToInt(argv[++i]);
+    }
+    else if ( arg.size() > 0 && arg[0] == '-' ) {
+      PrintUsage();
+      return 1;
+    }
+    else {
+      shards.emplace_back();
+      shards.back().fileName = arg;
+    }
+  }
+  if ( outputName.empty() || shards.empty() ) {
+    PrintUsage();
+    return 1;
+  }
+  nThreads = std::max(1, std::min(nThreads, G4int(shards.size())));
+
+  // Book the output with the layout used by the simulation
+  //
+  auto analysisManager = G4AnalysisManager::Instance();
+  analysisManager->SetVerboseLevel(1);
+  B4c::CreateHistograms();
+  B4c::CreateNtuples();
+  if ( ! analysisManager->OpenFile(outputName) ) {
+    G4cerr << "b4merge: cannot open " << outputName << G4endl;
+    return 1;
+  }
+
+  // Read the inputs in parallel; each reader thread takes the next
+  // unread input and has its own (thread-local) reader instance. The
+  // read-ahead is bounded: input i is read once i < written + nThreads
+  //
+  G4RootAnalysisReader::Instance(); // master instance
+  std::atomic<std::size_t> next(0);
+  std::size_t written = 0; // guarded by mutex
+  std::mutex mutex;
+  std::condition_variable readyCondition;
+  std::vector<std::thread> readers;
+  for ( G4int t = 0; t < nThreads; ++t ) {
+    readers.emplace_back([&, t]() {
+      G4Threading::G4SetThreadId(t);
+      auto reader = G4RootAnalysisReader::Instance();
+      reader->SetVerboseLevel(0);
+      for ( auto i = next++; i < shards.size(); i = next++ ) {
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          readyCondition.wait(lock, [&]() {
+            return i < written + std::size_t(nThreads); });
+        }
+        auto readable = ReadShard(reader, shards[i]);
+        std::lock_guard<std::mutex> lock(mutex);
+        shards[i].readable = readable;
+        shards[i].ready = true;
+        readyCondition.notify_all();
+      }
+    });
+  }
+
+  // Write the inputs in command line order as soon as they are read
+  //
+  G4bool mismatch = false;
+  G4int nofReadErrors = 0;
+  G4long totalPhotons = 0;
+  for ( auto& shard : shards ) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      readyCondition.wait(lock, [&shard]() { return shard.ready; });
+    }
+    if ( ! shard.readable ) {
+      G4cerr << "b4merge: " << shard.fileName
+             << ": cannot be read or holds no B4 histogram nor ntuple";
+      auto extension = shard.fileName.rfind(".b4p");
+      if ( extension != std::string::npos
+           && extension + 4 == shard.fileName.size() ) {
+        G4cerr << " (compact photon file: read it with b4decode)";
+      }
+      G4cerr << G4endl;
+      ++nofReadErrors;
+    }
+    else {
+      WriteShard(shard);
+
+      auto photons = shard.ntuples[0].nofRows;
+      auto recorded = GetRecordedPhotons(shard);
+      totalPhotons += G4long(photons);
+      G4cout << "b4merge: " << shard.fileName << ": " << photons
+             << " photons";
+      if ( ! shard.ntuples[0].found ) {
+        G4cout << " (no photon ntuple, not verified)";
+      }
+      else if ( recorded < 0 ) {
+        G4cout << " (no photon budget, not verified)";
+      }
+      else if ( recorded != G4long(photons) ) {
+        G4cout << " != " << recorded << " recorded in the photon budget";
+        mismatch = true;
+      }
+      G4cout << G4endl;
+    }
+
+    // Release the buffered columns and let the readers go on
+    shard.ntuples = std::vector<NtupleData>();
+    shard.histograms = std::vector<tools::histo::h1d>();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ++written;
+    }
+    readyCondition.notify_all();
+  }
+
+  for ( auto& reader : readers ) reader.join();
+
+  analysisManager->Write();
+  analysisManager->CloseFile();
+
+  G4cout << "b4merge: wrote " << totalPhotons << " photons from "
+         << shards.size() - std::size_t(nofReadErrors) << " files to "
+         << outputName << G4endl;
+  if ( nofReadErrors > 0 ) {
+    G4cerr << "b4merge: " << nofReadErrors << " of " << shards.size()
+           << " input files could not be read" << G4endl;
+    return 1;
+  }
+  if ( mismatch ) {
+    G4cerr << "b4merge: row counts do not match the photon budget" << G4endl;
+    return 2;
+  }
+  return 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,227 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+/// \file b4writebench.cc
+/// \brief Write throughput benchmark of the photon output
+///
+/// Usage: b4writebench -f root|hdf5 [-n photons] [-o result.json]
+///                     [-c "/B4/hdf5/chunkRows 16384"] ...
+///
+/// Writes the same synthetic photons, about 1000 per event, either as rows
+/// of the "B4" ntuple with the analysis manager, as the CalorimeterSD does
+/// (/B4/output/photons ntuple, file B4write.root), or with the HDF5Output
+/// (/B4/output/photons hdf5, file B4write.h5). The given commands are
+/// applied first, e.g. to tune the HDF5 chunking. The timing includes
+/// opening, writing and closing the file, but not the generation of the
+/// photons; the figures are printed and, with -o, written as JSON with the
+/// keys of bench/run_benchmark.py, so that bench/compare_benchmarks.py
+/// applies ("photons_per_s" is the number of rows written per second).
+///
+/// Exit code: 0 on success, 1 on usage or write errors.
+
+#include "HDF5Output.hh"
+#include "OutputSchema.hh"
+#include "PhotonHit.hh"
+
+#include "G4AnalysisManager.hh"
+#include "G4UIcommand.hh"
+#include "G4UImanager.hh"
+#include "globals.hh"
+
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <vector>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+
+  void PrintUsage() {
+    G4cerr << " Usage: " << G4endl;
+    G4cerr << " b4writebench -f root|hdf5 [-n photons] [-o result.json]"
+           << " [-c command] ..." << G4endl;
+  }
+
+  // A few events of photons, reused in turn for the whole benchmark
+  std::vector<B4c::PhotonHits> GenerateEvents(G4int nofEvents)
+  {
+    std::mt19937_64 engine(12345);
+    std::poisson_distribution<G4int> nofPhotons(1000.);
+    std::exponential_distribution<G4double> time(1./20.);
+    std::uniform_real_distribution<G4double> wavelength(300., 700.);
+    std::exponential_distribution<G4double> pathLength(1./30.);
+    std::uniform_int_distribution<G4int> creator(0, 2);
+
+    std::vector<B4c::PhotonHits> events(nofEvents);
+    for ( auto& hits : events ) {
+      for ( G4int i = nofPhotons(engine); i > 0; --i ) {
+        B4c::PhotonTrackInfo::PathLengths pathLengths;
+        for ( auto& length : pathLengths ) length = pathLength(engine);
+        hits.Add(B4c::PhotonHit(time(engine), wavelength(engine),
+                                pathLengths,
+                                B4c::PhotonSources::Creator(creator(engine))));
+      }
+    }
+    return events;
+  }
+
+  G4bool WriteRoot(const std::vector<B4c::PhotonHits>& events,
+                   G4long nofPhotons, G4long& nofEvents,
+                   const G4String& fileName)
+  {
+    auto analysisManager = G4AnalysisManager::Instance();
+    analysisManager->SetVerboseLevel(0);
+    B4c::CreateNtuples();
+    if ( ! analysisManager->OpenFile(fileName) ) return false;
+    G4long written = 0;
+    for ( nofEvents = 0; written < nofPhotons; ++nofEvents ) {
+      const auto& hits = events[nofEvents % events.size()];
+      for ( const auto& hit : hits ) {
+        analysisManager->FillNtupleDColumn(0, 0, nofEvents);
+        analysisManager->FillNtupleDColumn(0, 1, hit.GetWavelength());
+        analysisManager->FillNtupleDColumn(0, 2, hit.GetTime());
+        const auto& pathLengths = hit.GetPathLengths();
+        for ( G4int i = 0; i < B4c::PhotonTrackInfo::kNofPaths; ++i ) {
+          analysisManager->FillNtupleDColumn(0, 3+i, pathLengths[i]);
+        }
+        analysisManager->FillNtupleIColumn(0,
+          3+B4c::PhotonTrackInfo::kNofPaths, hit.GetCreator());
+        analysisManager->AddNtupleRow(0);
+      }
+      written += G4long(hits.GetSize());
+    }
+    G4bool ok = analysisManager->Write();
+    return analysisManager->CloseFile() && ok;
+  }
+
+  G4bool WriteHDF5(const std::vector<B4c::PhotonHits>& events,
+                   G4long nofPhotons, G4long& nofEvents,
+                   const G4String& fileName)
+  {
+    auto output = B4c::HDF5Output::Instance();
+    if ( ! output->Open(fileName) ) return false;
+    for ( nofEvents = 0; G4long(output->GetNofRows()) < nofPhotons;
+          ++nofEvents ) {
+      output->AddHits(nofEvents, events[nofEvents % events.size()]);
+    }
+    output->Close();
+    return true;
+  }
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+  // Evaluate arguments
+  //
+  G4String format;
+  G4String outputName;
+  G4long nofPhotons = 10000000;
+  std::vector<G4String> commands;
+  for ( G4int i=1; i<argc; ++i ) {
+    G4String arg = argv[i];
+    if ( arg == "-f" && i+1 < argc ) format = argv[++i];
+    else if ( arg == "-n" && i+1 < argc ) {
+      nofPhotons = G4UIcommand::ConvertToLongInt(argv[++i]);
+    }
+    else if ( arg == "-o" && i+1 < argc ) outputName = argv[++i];
+    else if ( arg == "-c" && i+1 < argc ) commands.push_back(argv[++i]);
+    else {
+      PrintUsage();
+      return 1;
+    }
+  }
+  if ( ( format != "root" && format != "hdf5" ) || nofPhotons <= 0 ) {
+    PrintUsage();
+    return 1;
+  }
+
+  // The commands of the HDF5 output exist once it is instantiated
+  B4c::HDF5Output::Instance();
+  for ( const auto& command : commands ) {
+    if ( G4UImanager::GetUIpointer()->ApplyCommand(command) != 0 ) {
+      G4cerr << "b4writebench: cannot apply " << command << G4endl;
+      return 1;
+    }
+  }
+
+  auto events = GenerateEvents(64);
+  G4String fileName = ( format == "root" ) ? "B4write.root" : "B4write.h5";
+
+  // Write
+  //
+  G4long nofEvents = 0;
+  auto start = std::chrono::steady_clock::now();
+  auto ok = ( format == "root" )
+    ? WriteRoot(events, nofPhotons, nofEvents, fileName)
+    : WriteHDF5(events, nofPhotons, nofEvents, fileName);
+  std::chrono::duration<G4double> time
+    = std::chrono::steady_clock::now() - start;
+  if ( ! ok ) {
+    G4cerr << "b4writebench: cannot write " << fileName << G4endl;
+    return 1;
+  }
+
+  G4long nofRows = 0;
+  for ( G4long i = 0; i < nofEvents; ++i ) {
+    nofRows += G4long(events[i % events.size()].GetSize());
+  }
+  std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+  G4long nofBytes = file.tellg();
+  auto seconds = time.count();
+
+  G4cout
+    << "b4writebench: " << format << ", " << nofRows << " photons in "
+    << nofEvents << " events, " << seconds << " s, "
+    << nofRows / seconds << " photons/s, "
+    << G4double(nofBytes) / nofRows << " bytes/photon" << G4endl;
+
+  if ( ! outputName.empty() ) {
+    std::ofstream json(outputName);
+    json
+      << "{\n"
+      << "  \"name\": \"write_" << format << "\",\n"
+      << "  \"threads\": 1,\n"
+      << "  \"events\": " << nofEvents << ",\n"
+      << "  \"photons_written\": " << nofRows << ",\n"
+      << "  \"write_s\": " << seconds << ",\n"
+      << "  \"events_per_s\": " << nofEvents / seconds << ",\n"
+      << "  \"photons_per_s\": " << nofRows / seconds << ",\n"
+      << "  \"mb_per_s\": " << nofBytes / seconds / 1e6 << ",\n"
+      << "  \"bytes_per_photon\": " << G4double(nofBytes) / nofRows << "\n"
+      << "}\n";
+    if ( ! json ) {
+      G4cerr << "b4writebench: cannot write " << outputName << G4endl;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......